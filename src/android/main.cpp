@@ -19,8 +19,27 @@ static Game::Main::InitConfig cfg = {
 	.graphics_type = MyGlib::Graphics::Manager::Type::Opengl,
 	.window_width_px = 0,
 	.window_height_px = 0,
+	.target_fps = Game::Config::target_fps,
+	.frame_pacing = Game::FramePacer::Mode::Hybrid,
 	.fullscreen = true,
 	.zoom = Game::Config::default_zoom,
+	.map_fname = "",
+	.headless = false,
+	.offscreen_video = Game::Main::OffscreenVideo::None,
+	.frame_dump_dir = "",
+	.frame_dump_interval = 1,
+	.headless_ticks = 0,
+	.headless_dt = Game::Config::sim_dt,
+	.batch_worlds = 0,
+	.frame_stats = false,
+	.late_input = false,
+	.threaded_sim = false,
+	.frame_stats_format = Game::FrameStats::Format::Text,
+	.frame_stats_fname = "",
+	.n_threads = 0,
+	.seed = std::nullopt,
+	.record_fname = "",
+	.replay_fname = "",
 };
 
 static int cpp_main (int argc, char **argv)
@@ -0,0 +1,372 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+
+#include "game-world.h"
+#include "renderer.h"
+#include "thread-pool.h"
+#include "lib.h"
+#include "config.h"
+#include "debug.h"
+
+/*
+	Microbenchmarks of the game code, over generated maps of several
+	sizes and ghost counts, rendering to a NullRenderer.
+	The results are printed as csv or json, one row per benchmark,
+	map size and ghost count.
+*/
+
+namespace Bench
+{
+
+// ---------------------------------------------------
+
+using namespace Game;
+
+enum class Format {
+	Csv,
+	Json
+};
+
+struct Params {
+	std::vector<uint32_t> sizes;
+	std::vector<uint32_t> ghost_counts;
+	std::vector<std::string> benchmarks; // if empty, all of them
+	double min_time; // in seconds, per benchmark
+	uint32_t min_iterations;
+	uint32_t max_iterations;
+	uint32_t n_threads;
+	uint64_t seed;
+	Format format;
+	std::string output_fname; // if empty, stdout
+};
+
+struct Result {
+	std::string benchmark;
+	uint32_t map_size;
+	uint32_t n_ghosts;
+	uint32_t n_threads;
+	uint32_t iterations;
+	double min_ns;
+	double median_ns;
+	double mean_ns;
+	double p99_ns;
+};
+
+static constexpr uint32_t window_width_px = 1920;
+static constexpr uint32_t window_height_px = 1080;
+
+static Params params = {
+	.sizes = { 8, 64, 256, 1024, 4096 },
+	.ghost_counts = { 1, 100, 1000, 10000, 100000 },
+	.benchmarks = { },
+	.min_time = 0.2,
+	.min_iterations = 3,
+	.max_iterations = 100000,
+	.n_threads = 1,
+	.seed = 1,
+	.format = Format::Csv,
+	.output_fname = "",
+};
+
+// ---------------------------------------------------
+
+static std::vector<uint32_t> parse_list (const std::string& str)
+{
+	std::vector<std::string> items;
+	std::vector<uint32_t> list;
+
+	boost::split(items, str, boost::is_any_of(","));
+
+	for (const std::string& item : items)
+		list.push_back( static_cast<uint32_t>( std::stoul(item) ) );
+
+	return list;
+}
+
+static void process_args (int argc, char **argv)
+{
+	boost::program_options::options_description cmd_line_args("Pacman benchmarks -- Options");
+	boost::program_options::variables_map vm;
+
+	try {
+		cmd_line_args.add_options()
+			( "help,h", "Help screen" )
+			( "sizes",
+				boost::program_options::value<std::string>(),
+				"Comma-separated widths of the square maps. Default: 8,64,256,1024,4096" )
+			( "ghosts",
+				boost::program_options::value<std::string>(),
+				"Comma-separated ghost counts. Default: 1,100,1000,10000,100000" )
+			( "bench",
+				boost::program_options::value<std::string>(),
+				"Comma-separated benchmarks to run: map_load, physics, wall_collisions, update_color, render_map, render, save_state, restore_state. Default: all" )
+			( "min-time",
+				boost::program_options::value<double>()->default_value(params.min_time),
+				"Minimum time in seconds spent in each benchmark" )
+			( "max-iterations",
+				boost::program_options::value<uint32_t>()->default_value(params.max_iterations),
+				"Maximum number of iterations of each benchmark" )
+			( "threads",
+				boost::program_options::value<uint32_t>()->default_value(params.n_threads),
+				"Number of threads used by the simulation" )
+			( "seed",
+				boost::program_options::value<uint64_t>()->default_value(params.seed),
+				"Seed of the random numbers" )
+			( "format",
+				boost::program_options::value<std::string>(),
+				"Output format: csv or json. Default: csv" )
+			( "output",
+				boost::program_options::value<std::string>(),
+				"Write the results to this file instead of stdout" )
+			;
+
+		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, cmd_line_args), vm);
+		boost::program_options::notify(vm);
+
+		if (vm.count("help")) {
+			std::cout << cmd_line_args << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+
+		if (vm.count("sizes"))
+			params.sizes = parse_list(vm["sizes"].as<std::string>());
+
+		if (vm.count("ghosts"))
+			params.ghost_counts = parse_list(vm["ghosts"].as<std::string>());
+
+		if (vm.count("bench"))
+			boost::split(params.benchmarks, vm["bench"].as<std::string>(), boost::is_any_of(","));
+
+		params.min_time = vm["min-time"].as<double>();
+		params.max_iterations = std::max(vm["max-iterations"].as<uint32_t>(), 1u);
+		params.n_threads = std::max(vm["threads"].as<uint32_t>(), 1u);
+		params.seed = vm["seed"].as<uint64_t>();
+
+		if (vm.count("format")) {
+			const std::string& format = vm["format"].as<std::string>();
+
+			if (boost::iequals(format, "csv"))
+				params.format = Format::Csv;
+			else if (boost::iequals(format, "json"))
+				params.format = Format::Json;
+			else
+				throw std::runtime_error("Bad output format!");
+		}
+
+		if (vm.count("output"))
+			params.output_fname = vm["output"].as<std::string>();
+	}
+	catch (const boost::program_options::error& ex) {
+		throw std::runtime_error(ex.what());
+	}
+}
+
+// ---------------------------------------------------
+
+static bool is_enabled (const std::string& benchmark)
+{
+	return params.benchmarks.empty()
+	    || std::find(params.benchmarks.begin(), params.benchmarks.end(), benchmark) != params.benchmarks.end();
+}
+
+/*
+	Runs func until both min_time and min_iterations are reached,
+	timing every iteration.
+*/
+
+static Result measure (const std::string& benchmark, const uint32_t map_size, const uint32_t n_ghosts, const std::function<void ()>& func)
+{
+	std::vector<double> samples;
+	double total = 0.0;
+
+	while (samples.size() < params.max_iterations
+	       && (samples.size() < params.min_iterations || total < params.min_time)) {
+		const ClockTime tbegin = Clock::now();
+		func();
+		const double elapsed = ClockDuration_to_double(Clock::now() - tbegin);
+
+		samples.push_back(elapsed * 1e9);
+		total += elapsed;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	const size_t n = samples.size();
+
+	return Result {
+		.benchmark = benchmark,
+		.map_size = map_size,
+		.n_ghosts = n_ghosts,
+		.n_threads = params.n_threads,
+		.iterations = static_cast<uint32_t>(n),
+		.min_ns = samples.front(),
+		.median_ns = samples[n / 2],
+		.mean_ns = (total * 1e9) / static_cast<double>(n),
+		.p99_ns = samples[ std::min(n - 1, (n * 99) / 100) ]
+	};
+}
+
+static void run_benchmarks (const uint32_t map_size, const uint32_t n_ghosts, ThreadPool& pool, Renderer& renderer, std::vector<Result>& results)
+{
+	const std::string map_fname = (std::filesystem::temp_directory_path() / "pacman-bench.pmap").string();
+
+	if (is_enabled("map_load")) {
+		Map(map_size, map_size, n_ghosts).save_binary(map_fname);
+
+		results.push_back( measure("map_load", map_size, n_ghosts, [&map_fname] {
+			const Map map(map_fname);
+		}) );
+
+		std::filesystem::remove(map_fname);
+	}
+
+	World world(Map(map_size, map_size, n_ghosts), params.seed);
+	world.set_thread_pool(&pool);
+	world.get_ref_context().renderer = &renderer;
+
+	if (is_enabled("physics")) {
+		results.push_back( measure("physics", map_size, n_ghosts, [&world] {
+			world.physics(Config::sim_dt, nullptr);
+		}) );
+	}
+
+	// the ghosts don't choose new directions here, so most of them soon stop
+	// against a wall, but every iteration still checks the exits of every ghost
+	if (is_enabled("wall_collisions")) {
+		results.push_back( measure("wall_collisions", map_size, n_ghosts, [&world] {
+			world.move_and_collide_ghosts(Config::sim_dt);
+		}) );
+	}
+
+	if (is_enabled("update_color")) {
+		results.push_back( measure("update_color", map_size, n_ghosts, [&world] {
+			world.get_ref_player().update_color();
+		}) );
+	}
+
+	if (is_enabled("render_map")) {
+		const Map::TileRect all = { .x_begin = 0, .y_begin = 0, .x_end = map_size, .y_end = map_size };
+
+		results.push_back( measure("render_map", map_size, n_ghosts, [&world, &all] {
+			world.render_map(all, Color(0.0f, 0.0f, 1.0f, 1.0f));
+		}) );
+	}
+
+	if (is_enabled("render")) {
+		results.push_back( measure("render", map_size, n_ghosts, [&world] {
+			world.render(1.0f);
+		}) );
+	}
+
+	if (is_enabled("save_state") || is_enabled("restore_state")) {
+		std::vector<uint8_t> state, state_again;
+
+		world.save_state(state);
+		world.save_state(state_again);
+
+		// the states are compared byte by byte, so the padding must be saved as zeros
+		mylib_assert_exception_msg(state == state_again, "saving the same world twice gave different states")
+
+		if (is_enabled("save_state")) {
+			results.push_back( measure("save_state", map_size, n_ghosts, [&world, &state] {
+				world.save_state(state);
+			}) );
+		}
+
+		if (is_enabled("restore_state")) {
+			results.push_back( measure("restore_state", map_size, n_ghosts, [&world, &state] {
+				world.restore_state(state);
+			}) );
+		}
+	}
+}
+
+static void report (std::ostream& out, const std::vector<Result>& results)
+{
+	out << std::fixed;
+	out.precision(1);
+
+	switch (params.format) {
+		case Format::Csv:
+			out << "benchmark,map_w,map_h,n_ghosts,n_threads,iterations,min_ns,median_ns,mean_ns,p99_ns" << '\n';
+
+			for (const Result& r : results) {
+				out << r.benchmark << ',' << r.map_size << ',' << r.map_size << ',' << r.n_ghosts << ',' << r.n_threads
+				    << ',' << r.iterations << ',' << r.min_ns << ',' << r.median_ns << ',' << r.mean_ns << ',' << r.p99_ns << '\n';
+			}
+		break;
+
+		case Format::Json:
+			out << "[" << '\n';
+
+			for (size_t i = 0; i < results.size(); i++) {
+				const Result& r = results[i];
+
+				out << "  { \"benchmark\": \"" << r.benchmark << "\""
+				    << ", \"map_w\": " << r.map_size << ", \"map_h\": " << r.map_size
+				    << ", \"n_ghosts\": " << r.n_ghosts << ", \"n_threads\": " << r.n_threads
+				    << ", \"iterations\": " << r.iterations
+				    << ", \"min_ns\": " << r.min_ns << ", \"median_ns\": " << r.median_ns
+				    << ", \"mean_ns\": " << r.mean_ns << ", \"p99_ns\": " << r.p99_ns << " }"
+				    << ((i + 1) < results.size() ? "," : "") << '\n';
+			}
+
+			out << "]" << '\n';
+		break;
+	}
+}
+
+// ---------------------------------------------------
+
+} // end namespace Bench
+
+int main (const int argc, char **argv)
+{
+	using namespace Bench;
+
+	try {
+		process_args(argc, argv);
+
+		NullRenderer null_renderer(window_width_px, window_height_px);
+
+		ThreadPool pool(params.n_threads);
+		std::vector<Result> results;
+
+		// the game logs to stdout, so we mute it while the benchmarks run
+		std::streambuf *cout_buffer = std::cout.rdbuf(nullptr);
+
+		for (const uint32_t map_size : params.sizes) {
+			for (const uint32_t n_ghosts : params.ghost_counts) {
+				std::cerr << "map " << map_size << "x" << map_size << ", " << n_ghosts << " ghosts" << std::endl;
+				run_benchmarks(map_size, n_ghosts, pool, null_renderer, results);
+			}
+		}
+
+		std::cout.rdbuf(cout_buffer);
+		std::cout.clear();
+
+		if (params.output_fname.empty())
+			report(std::cout, results);
+		else {
+			std::ofstream out(params.output_fname);
+			mylib_assert_exception_msg(out.is_open(), "cannot open ", params.output_fname)
+			report(out, results);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Something bad happened!" << '\n' << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -10,10 +10,6 @@ namespace Config
 
 // ---------------------------------------------------
 
-inline constexpr bool sleep_to_save_cpu = true;
-
-inline constexpr bool busy_wait_to_ensure_fps = true;
-
 inline constexpr uint32_t default_window_width_px = 700;
 
 inline constexpr uint32_t default_window_height_px = 700;
@@ -30,27 +26,64 @@ inline constexpr float ghost_radius = 0.3f;
 
 inline constexpr float ghost_time_between_turns = 0.5f; // in seconds
 
+// probability of a ghost taking the shortest path to pacman when choosing a direction
+inline constexpr float ghost_chase_probability = 0.3f;
+
+// max number of cells visited per tick when rebuilding the flow field to pacman
+inline constexpr uint32_t flow_field_cells_per_tick = 1 << 16;
+
+// ghosts are simulated in chunks of this size, which may run in parallel
+inline constexpr uint32_t ghost_chunk_size = 2048;
+
+// the environments of a VecEnv are stepped in chunks of this size, which may run in parallel
+inline constexpr uint32_t vec_env_chunk_size = 64;
+
 inline constexpr float map_tile_color_change_time = 2.0f; // in seconds
 
 inline constexpr float ghost_color_change_time = 0.2f; // in seconds
 
+inline constexpr float timer_wheel_resolution = 0.001f; // in seconds
+
 inline constexpr float map_tile_size = 1.0f;
 
+// walls are merged and culled in square chunks of this number of tiles
+inline constexpr uint32_t map_wall_chunk_size = 16;
+
+// default, can be changed at run time
 inline constexpr float target_fps = 60.0f;
 
 // if fps gets lower than min_fps, we slow down the simulation
 inline constexpr float min_fps = 30.0f;
 
-inline constexpr float target_dt = 1.0f / target_fps;
-
 inline constexpr float max_dt = 1.0f / min_fps;
 
-inline constexpr float sleep_threshold = target_dt * 0.9f;
+// the frame pacer starts assuming that the OS wakes us up this late, in seconds
+inline constexpr float frame_pacer_initial_overshoot = 0.001f;
+
+// weight of each new overshoot in its moving averages
+inline constexpr float frame_pacer_learning_rate = 0.05f;
+
+// the frame pacer wakes up the mean overshoot plus this many deviations before the deadline
+inline constexpr float frame_pacer_overshoot_deviations = 3.0f;
+
+// and spins at least this long, in seconds
+inline constexpr float frame_pacer_min_spin = 0.0001f;
+
+// the simulation is always stepped with this fixed dt, independently of the frame rate
+inline constexpr float sim_dt = 1.0f / 120.0f;
+
+// max number of simulation steps in a single frame when catching up
+inline constexpr uint32_t max_sim_steps_per_frame = 8;
 
 inline constexpr float pacman_max_delta_per_cycle = pacman_speed * max_dt;
 
 inline constexpr float pacman_turn_threshold = pacman_max_delta_per_cycle * 1.0f;
 
+inline constexpr uint64_t headless_default_ticks = 100000;
+
+// the software renderer rasterizes each tile of this size (in pixels) in a single task
+inline constexpr uint32_t software_renderer_tile_size = 64;
+
 // ---------------------------------------------------
 
 } // end namespace Config
@@ -6,6 +6,7 @@
 #include "lib.h"
 #include "game-object.h"
 #include "game-world.h"
+#include "sim-thread.h"
 
 
 namespace Game
@@ -30,27 +31,48 @@ const char* enum_class_to_str (const MoveData::Direction value)
 
 // ---------------------------------------------------
 
+// the input latency is measured from here
+
+static void publish_move (const MoveData::Direction direction)
+{
+	Main *main = Main::get();
+
+	main->get_ref_input_latency().input_received( Clock::now() );
+
+	// the simulation thread publishes it before its next tick
+	if (main->get_sim_thread() != nullptr)
+		main->get_sim_thread()->push_input(MoveData { .direction = direction });
+	else
+		main->get_world()->get_ref_context().move.publish(MoveData { .direction = direction });
+}
+
+// ---------------------------------------------------
+
 static void key_down_callback (const KeyDown::Type& event)
 {
 	switch (event.key_code) {
 		case SDLK_LEFT:
-			move.publish(MoveData { .direction = MoveData::Direction::Left });
+			publish_move(MoveData::Direction::Left);
 		break;
 
 		case SDLK_RIGHT:
-			move.publish(MoveData { .direction = MoveData::Direction::Right });
+			publish_move(MoveData::Direction::Right);
 		break;
 
 		case SDLK_UP:
-			move.publish(MoveData { .direction = MoveData::Direction::Up });
+			publish_move(MoveData::Direction::Up);
 		break;
 
 		case SDLK_DOWN:
-			move.publish(MoveData { .direction = MoveData::Direction::Down });
+			publish_move(MoveData::Direction::Down);
 		break;
 
 		case SDLK_ESCAPE:
-			event_manager->quit().publish( {} );
+			Main::get()->get_event_manager()->quit().publish( {} );
+		break;
+
+		case SDLK_F12:
+			Main::get()->report_frame_stats();
 		break;
 	}
 }
@@ -63,29 +85,29 @@ static void touch_screen_move_callback (const TouchScreenMove::Type& event)
 		using enum TouchScreenMove::Type::Direction;
 
 		case Left:
-			move.publish(MoveData { .direction = MoveData::Direction::Left });
+			publish_move(MoveData::Direction::Left);
 			break;
 		
 		case Right:
-			move.publish(MoveData { .direction = MoveData::Direction::Right });
+			publish_move(MoveData::Direction::Right);
 			break;
 		
 		case Up:
-			move.publish(MoveData { .direction = MoveData::Direction::Up });
+			publish_move(MoveData::Direction::Up);
 			break;
 		
 		case Down:
-			move.publish(MoveData { .direction = MoveData::Direction::Down });
+			publish_move(MoveData::Direction::Down);
 			break;
 	}
 }
 
 // ---------------------------------------------------
 
-void setup_events ()
+void setup_events (Manager& event_manager)
 {
-	event_manager->key_down().subscribe( Mylib::Event::make_callback_function<KeyDown::Type>(&key_down_callback) );
-	event_manager->touch_screen_move().subscribe( Mylib::Event::make_callback_function<TouchScreenMove::Type>(&touch_screen_move_callback) );
+	event_manager.key_down().subscribe( Mylib::Event::make_callback_function<KeyDown::Type>(&key_down_callback) );
+	event_manager.touch_screen_move().subscribe( Mylib::Event::make_callback_function<TouchScreenMove::Type>(&touch_screen_move_callback) );
 }
 
 // ---------------------------------------------------
@@ -11,9 +11,9 @@
 
 #include <my-lib/std.h>
 #include <my-lib/event.h>
-#include <my-lib/event-timer.h>
 
 #include "lib.h"
+#include "timer-wheel.h"
 
 namespace Game
 {
@@ -30,8 +30,7 @@ using MyGlib::Event::TouchScreenMove;
 
 // ---------------------------------------------------
 
-inline Mylib::Event::Timer timer( Clock::now );
-using Timer = decltype(timer);
+using Timer = TimingWheel;
 
 // ---------------------------------------------------
 
@@ -62,22 +61,34 @@ inline std::ostream& operator << (std::ostream& out, const MoveData::Direction v
 	return out;
 }
 
-inline Move move;
-
 // ---------------------------------------------------
 
+/*
+	Published once per tick for every entity that hit a wall, ghosts included.
+	The entities themselves are notified directly by the world,
+	so only observers that want to see every collision need to subscribe.
+*/
+
 struct WallCollisionData {
-	Object& coll_obj;
+	uint32_t entity_id; // same ids as World::entity_grid
 	MoveData::Direction direction;
 };
 
 using WallCollision = Mylib::Event::Handler<WallCollisionData>;
 
-inline WallCollision wall_collision;
+// ---------------------------------------------------
+
+struct GhostContactData {
+	Object& pacman;
+	uint32_t ghost_id;
+};
+
+using GhostContact = Mylib::Event::Handler<GhostContactData>;
 
 // ---------------------------------------------------
 
-void setup_events ();
+// the input of the player, for the world of Main
+void setup_events (Manager& event_manager);
 
 // ---------------------------------------------------
 
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <utility>
+#include <limits>
+
+#include "flow-field.h"
+#include "game-world.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+FlowField::FlowField ()
+{
+	this->w = 0;
+	this->h = 0;
+	this->target_x = 0;
+	this->target_y = 0;
+	this->n_builds = 0;
+	this->queue_head = 0;
+	this->queue_tail = 0;
+	this->building_target = 0;
+	this->is_building = false;
+}
+
+void FlowField::reset (const Map& map, const uint32_t x, const uint32_t y)
+{
+	this->w = map.get_w();
+	this->h = map.get_h();
+
+	const size_t n_cells = static_cast<size_t>(this->w) * static_cast<size_t>(this->h);
+
+	this->directions.assign(n_cells, unvisited);
+	this->building.assign(n_cells, unvisited);
+	this->queue.resize(n_cells);
+
+	this->start_build(y * this->w + x);
+	this->continue_build(map, std::numeric_limits<uint32_t>::max());
+}
+
+void FlowField::update (const Map& map, const uint32_t x, const uint32_t y)
+{
+	const uint32_t target = y * this->w + x;
+
+	// a build is always finished before starting another one,
+	// otherwise a fast target could starve the field
+	if (!this->is_building && (x != this->target_x || y != this->target_y))
+		this->start_build(target);
+
+	if (this->is_building)
+		this->continue_build(map, Config::flow_field_cells_per_tick);
+}
+
+void FlowField::get_state (State& state) const
+{
+	state.target_x = this->target_x;
+	state.target_y = this->target_y;
+	state.n_builds = this->n_builds;
+	state.building_target = this->building_target;
+	state.n_built = this->queue_head;
+	state.is_building = this->is_building;
+}
+
+void FlowField::restore_state (const Map& map, const State& state)
+{
+	if (state.target_x != this->target_x || state.target_y != this->target_y)
+		this->reset(map, state.target_x, state.target_y);
+
+	const bool same_build = state.is_building
+	                     ? (this->is_building && state.building_target == this->building_target && state.n_built == this->queue_head)
+	                     : !this->is_building;
+
+	if (!same_build) {
+		this->is_building = false;
+
+		if (state.is_building) {
+			this->start_build(state.building_target);
+			this->continue_build(map, state.n_built);
+		}
+	}
+
+	this->n_builds = state.n_builds;
+}
+
+void FlowField::start_build (const uint32_t target)
+{
+	std::fill(this->building.begin(), this->building.end(), unvisited);
+
+	this->building[target] = static_cast<uint8_t>(Direction::Stopped);
+	this->queue[0] = target;
+	this->queue_head = 0;
+	this->queue_tail = 1;
+	this->building_target = target;
+	this->is_building = true;
+}
+
+bool FlowField::continue_build (const Map& map, uint32_t budget)
+{
+	using enum Direction;
+
+	// the neighbour found through an exit must walk in the opposite direction to come back
+	auto visit = [this] (const uint32_t cell, const Direction back) {
+		if (this->building[cell] == unvisited) {
+			this->building[cell] = static_cast<uint8_t>(back);
+			this->queue[this->queue_tail++] = cell;
+		}
+	};
+
+	while (this->queue_head < this->queue_tail && budget > 0) {
+		const uint32_t cell = this->queue[this->queue_head++];
+		const uint32_t x = cell % this->w;
+		const uint32_t y = cell / this->w;
+		const uint8_t exits = map.get_exits(x, y);
+
+		if (exits & Map::exit_left)
+			visit(cell - 1, Right);
+		if (exits & Map::exit_right)
+			visit(cell + 1, Left);
+		if (exits & Map::exit_up)
+			visit(cell - this->w, Down);
+		if (exits & Map::exit_down)
+			visit(cell + this->w, Up);
+
+		budget--;
+	}
+
+	if (this->queue_head < this->queue_tail)
+		return false;
+
+	std::swap(this->directions, this->building);
+	this->target_x = this->building_target % this->w;
+	this->target_y = this->building_target / this->w;
+	this->is_building = false;
+	this->n_builds++;
+
+	return true;
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
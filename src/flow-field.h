@@ -0,0 +1,107 @@
+#ifndef __PACMAN_SDL_OPENGL_FLOW_FIELD_HEADER_H__
+#define __PACMAN_SDL_OPENGL_FLOW_FIELD_HEADER_H__
+
+#include <vector>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "config.h"
+#include "events.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+class Map;
+
+// ---------------------------------------------------
+
+/*
+	For every cell of the map, the direction of the first step
+	of a shortest path to a target cell, computed by a BFS from the target.
+	All ghosts share the same field, so chasing costs one lookup per ghost.
+
+	The field is only rebuilt when the target changes tile.
+	The new field is built in the background, at most
+	Config::flow_field_cells_per_tick cells per update, while the
+	previous one is still used, so big maps don't cause frame spikes.
+*/
+
+class FlowField
+{
+public:
+	using Direction = Events::MoveData::Direction;
+
+	// enough to rebuild the field, since the BFS is deterministic
+	struct State {
+		uint32_t target_x;
+		uint32_t target_y;
+		uint64_t n_builds;
+		uint32_t building_target;
+		uint32_t n_built; // cells already visited by the build in progress
+		bool is_building;
+	};
+
+protected:
+	static constexpr uint8_t unvisited = 0xFF;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, w)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, h)
+
+	// target of the current field
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, target_x)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, target_y)
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_builds)
+
+	// per cell, in row-major order, a Direction or unvisited
+	std::vector<uint8_t> directions;
+
+	// field being built, with the BFS queue
+	std::vector<uint8_t> building;
+	std::vector<uint32_t> queue;
+	uint32_t queue_head;
+	uint32_t queue_tail;
+	uint32_t building_target;
+	bool is_building;
+
+public:
+	FlowField ();
+
+	// builds the whole field towards (x, y) at once
+	void reset (const Map& map, const uint32_t x, const uint32_t y);
+
+	// keeps the field pointing to (x, y), rebuilding it in steps if needed
+	void update (const Map& map, const uint32_t x, const uint32_t y);
+
+	// only writes the fields, so the caller can zero the padding first
+	void get_state (State& state) const;
+
+	/*
+		Only rebuilds what differs from the current field, so
+		restoring a recent state of the same map is usually free.
+	*/
+	void restore_state (const Map& map, const State& state);
+
+	// returns Stopped in the target and in cells that can't reach it
+	inline Direction get_direction (const uint32_t x, const uint32_t y) const
+	{
+		const uint8_t v = this->directions[y * this->w + x];
+
+		return (v == unvisited) ? Direction::Stopped : static_cast<Direction>(v);
+	}
+
+protected:
+	void start_build (const uint32_t target);
+
+	// returns true when the build is finished
+	bool continue_build (const Map& map, uint32_t budget);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <iomanip>
+
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#include <time.h>
+#endif
+
+#include "frame-pacer.h"
+#include "config.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	static constexpr bool has_thread_cpu_time = true;
+
+	// CPU time used by the calling thread, in seconds
+	static double get_thread_cpu_time ()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+	}
+#else
+	static constexpr bool has_thread_cpu_time = false;
+
+	static double get_thread_cpu_time ()
+	{
+		return 0.0;
+	}
+#endif
+
+// ---------------------------------------------------
+
+FramePacer::FramePacer (const Mode mode_)
+{
+	this->mode = mode_;
+	this->overshoot_mean = Config::frame_pacer_initial_overshoot;
+	this->overshoot_deviation = Config::frame_pacer_initial_overshoot;
+	this->sleep_wall_time = 0.0;
+	this->sleep_cpu_time = 0.0;
+	this->spin_wall_time = 0.0;
+	this->spin_cpu_time = 0.0;
+	this->n_waits = 0;
+	this->n_late_wakeups = 0;
+}
+
+float FramePacer::get_wakeup_margin () const
+{
+	return this->overshoot_mean + Config::frame_pacer_overshoot_deviations * this->overshoot_deviation + Config::frame_pacer_min_spin;
+}
+
+FramePacer::Wait FramePacer::wait_until (const ClockTime deadline)
+{
+	const ClockTime tbegin = Clock::now();
+	const double cpu_begin = get_thread_cpu_time();
+
+	this->n_waits++;
+
+	if (this->mode == Mode::None || tbegin >= deadline)
+		return Wait { .sleep = ClockDuration::zero(), .spin = ClockDuration::zero() };
+
+	ClockTime twake = tbegin;
+
+	if (this->mode == Mode::Sleep || this->mode == Mode::Hybrid) {
+		const ClockTime target = (this->mode == Mode::Sleep) ? deadline : (deadline - float_to_ClockDuration(this->get_wakeup_margin()));
+
+		if (target > tbegin) {
+			std::this_thread::sleep_until(target);
+			twake = Clock::now();
+
+			// learn how late the OS wakes us up
+			const float overshoot = std::max(ClockDuration_to_float(twake - target), 0.0f);
+			constexpr float a = Config::frame_pacer_learning_rate;
+
+			this->overshoot_deviation += a * (std::abs(overshoot - this->overshoot_mean) - this->overshoot_deviation);
+			this->overshoot_mean += a * (overshoot - this->overshoot_mean);
+
+			if (twake > deadline)
+				this->n_late_wakeups++;
+		}
+	}
+
+	const double cpu_wake = get_thread_cpu_time();
+	ClockTime tend = twake;
+
+	if (this->mode == Mode::Spin || this->mode == Mode::Hybrid) {
+		while (tend < deadline)
+			tend = Clock::now();
+	}
+
+	const double cpu_end = get_thread_cpu_time();
+
+	this->sleep_wall_time += ClockDuration_to_double(twake - tbegin);
+	this->sleep_cpu_time += cpu_wake - cpu_begin;
+	this->spin_wall_time += ClockDuration_to_double(tend - twake);
+	this->spin_cpu_time += cpu_end - cpu_wake;
+
+	return Wait { .sleep = twake - tbegin, .spin = tend - twake };
+}
+
+void FramePacer::report (std::ostream& out) const
+{
+	out << "frame pacing (" << enum_class_to_str(this->mode) << ", " << this->n_waits << " frames, " << this->n_late_wakeups << " late wake-ups";
+
+	if (this->mode == Mode::Hybrid)
+		out << ", wake-up margin " << (this->get_wakeup_margin() * 1000.0f) << " ms";
+
+	out << ")" << std::endl;
+
+	out << "sleeping: " << this->sleep_wall_time << " s wall";
+
+	if constexpr (has_thread_cpu_time)
+		out << ", " << this->sleep_cpu_time << " s cpu";
+
+	out << std::endl << "spinning: " << this->spin_wall_time << " s wall";
+
+	if constexpr (has_thread_cpu_time)
+		out << ", " << this->spin_cpu_time << " s cpu";
+
+	out << std::endl;
+}
+
+const char* FramePacer::enum_class_to_str (const Mode value)
+{
+	static constexpr auto strs = std::to_array<const char*>({
+		#define _MYLIB_ENUM_CLASS_MODE_VALUE_(V) #V,
+		_MYLIB_ENUM_CLASS_MODE_VALUES_
+		#undef _MYLIB_ENUM_CLASS_MODE_VALUE_
+	});
+
+	mylib_assert_exception_msg(std::to_underlying(value) < strs.size(), "invalid enum class value ", std::to_underlying(value))
+
+	return strs[ std::to_underlying(value) ];
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef __PACMAN_SDL_OPENGL_FRAME_PACER_HEADER_H__
+#define __PACMAN_SDL_OPENGL_FRAME_PACER_HEADER_H__
+
+#include <ostream>
+#include <utility>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "lib.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Waits for the end of each frame.
+
+	In the Hybrid mode, it sleeps on the monotonic clock until a bit
+	before the deadline, and spins for the rest.
+	How early it wakes up is learned from the overshoot of the
+	previous sleeps (how late the OS woke us up): a moving average
+	of the overshoot plus some deviations, so that the spin is
+	only as long as the OS jitter requires.
+	Sleep only sleeps, accepting the overshoot, Spin only spins,
+	and None returns right away (for vsync).
+
+	The wall and CPU time of the current thread spent sleeping and
+	spinning are accumulated for the report.
+*/
+
+class FramePacer
+{
+public:
+	#define _MYLIB_ENUM_CLASS_MODE_VALUES_ \
+		_MYLIB_ENUM_CLASS_MODE_VALUE_(None) \
+		_MYLIB_ENUM_CLASS_MODE_VALUE_(Sleep) \
+		_MYLIB_ENUM_CLASS_MODE_VALUE_(Spin) \
+		_MYLIB_ENUM_CLASS_MODE_VALUE_(Hybrid)
+
+	enum class Mode : uint32_t {
+		#define _MYLIB_ENUM_CLASS_MODE_VALUE_(V) V,
+		_MYLIB_ENUM_CLASS_MODE_VALUES_
+		#undef _MYLIB_ENUM_CLASS_MODE_VALUE_
+	};
+
+	static constexpr uint32_t n_modes = std::to_underlying(Mode::Hybrid) + 1;
+
+	struct Wait {
+		ClockDuration sleep;
+		ClockDuration spin;
+	};
+
+protected:
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(Mode, mode)
+
+	// overshoot of the sleeps, in seconds
+	float overshoot_mean;
+	float overshoot_deviation;
+
+	// totals, in seconds
+	double sleep_wall_time;
+	double sleep_cpu_time;
+	double spin_wall_time;
+	double spin_cpu_time;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_waits)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_late_wakeups) // woke up after the deadline
+
+public:
+	FramePacer (const Mode mode_ = Mode::Hybrid);
+
+	// how early the hybrid mode wakes up before the deadline, in seconds
+	float get_wakeup_margin () const;
+
+	Wait wait_until (const ClockTime deadline);
+
+	void report (std::ostream& out) const;
+
+	static const char* enum_class_to_str (const Mode value);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <vector>
+#include <array>
+#include <iomanip>
+
+#include "frame-stats.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+namespace {
+
+struct Percentiles {
+	float p50;
+	float p95;
+	float p99;
+	float max;
+};
+
+} // end anonymous namespace
+
+// ---------------------------------------------------
+
+FrameStats::FrameStats ()
+{
+	this->n_recorded_frames = 0;
+	this->current_frame.fill(0.0f);
+}
+
+void FrameStats::end_frame ()
+{
+	const uint32_t i = static_cast<uint32_t>(this->n_recorded_frames % n_frames);
+
+	for (uint32_t phase = 0; phase < n_phases; phase++)
+		this->samples[phase][i] = this->current_frame[phase];
+
+	this->current_frame.fill(0.0f);
+	this->n_recorded_frames++;
+}
+
+void FrameStats::report (std::ostream& out, const Format format) const
+{
+	const uint32_t n = static_cast<uint32_t>( std::min<uint64_t>(this->n_recorded_frames, n_frames) );
+	std::array<Percentiles, n_phases> result;
+	std::vector<float> sorted(n);
+
+	for (uint32_t phase = 0; phase < n_phases; phase++) {
+		if (n == 0) {
+			result[phase] = Percentiles { .p50 = 0.0f, .p95 = 0.0f, .p99 = 0.0f, .max = 0.0f };
+			continue;
+		}
+
+		// the order of the samples inside the ring buffer does not matter here
+		std::copy_n(this->samples[phase].begin(), n, sorted.begin());
+		std::sort(sorted.begin(), sorted.end());
+
+		auto percentile = [&sorted, n] (const float p) -> float {
+			return sorted[ static_cast<uint32_t>(p * static_cast<float>(n - 1)) ] * 1000.0f; // in ms
+		};
+
+		result[phase] = Percentiles {
+			.p50 = percentile(0.50f),
+			.p95 = percentile(0.95f),
+			.p99 = percentile(0.99f),
+			.max = sorted.back() * 1000.0f
+			};
+	}
+
+	switch (format) {
+		case Format::Text:
+			out << "frame stats (last " << n << " of " << this->n_recorded_frames << " frames, in ms)" << std::endl;
+			out << std::left << std::setw(16) << "phase" << std::right
+				<< std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+
+			for (uint32_t phase = 0; phase < n_phases; phase++) {
+				const Percentiles& r = result[phase];
+				out << std::left << std::setw(16) << enum_class_to_str( static_cast<Phase>(phase) ) << std::right
+					<< std::setw(10) << r.p50 << std::setw(10) << r.p95 << std::setw(10) << r.p99 << std::setw(10) << r.max << std::endl;
+			}
+		break;
+
+		case Format::Csv:
+			out << "phase,frames,p50_ms,p95_ms,p99_ms,max_ms" << std::endl;
+
+			for (uint32_t phase = 0; phase < n_phases; phase++) {
+				const Percentiles& r = result[phase];
+				out << enum_class_to_str( static_cast<Phase>(phase) ) << ',' << n << ','
+					<< r.p50 << ',' << r.p95 << ',' << r.p99 << ',' << r.max << std::endl;
+			}
+		break;
+
+		case Format::Json:
+			out << "{\"frames\": " << n << ", \"total_frames\": " << this->n_recorded_frames << ", \"phases\": {";
+
+			for (uint32_t phase = 0; phase < n_phases; phase++) {
+				const Percentiles& r = result[phase];
+				out << (phase ? ", " : "") << '"' << enum_class_to_str( static_cast<Phase>(phase) ) << "\": {"
+					<< "\"p50_ms\": " << r.p50 << ", \"p95_ms\": " << r.p95 << ", \"p99_ms\": " << r.p99 << ", \"max_ms\": " << r.max << '}';
+			}
+
+			out << "}}" << std::endl;
+		break;
+	}
+}
+
+const char* FrameStats::enum_class_to_str (const Phase value)
+{
+	static constexpr auto strs = std::to_array<const char*>({
+		#define _MYLIB_ENUM_CLASS_PHASE_VALUE_(V) #V,
+		_MYLIB_ENUM_CLASS_PHASE_VALUES_
+		#undef _MYLIB_ENUM_CLASS_PHASE_VALUE_
+	});
+
+	mylib_assert_exception_msg(std::to_underlying(value) < strs.size(), "invalid enum class value ", std::to_underlying(value))
+
+	return strs[ std::to_underlying(value) ];
+}
+
+// ---------------------------------------------------
+
+InputLatency::InputLatency ()
+{
+	this->histogram.fill(0);
+	this->total = 0.0;
+	this->max = 0.0f;
+	this->n_simulated = 0;
+	this->n_presented = 0;
+}
+
+void InputLatency::inputs_simulated (const uint64_t n_total)
+{
+	const size_t n = static_cast<size_t>( std::min<uint64_t>(n_total - std::min(n_total, this->n_simulated), this->received.size()) );
+
+	this->simulated.insert(this->simulated.end(), this->received.begin(), this->received.begin() + n);
+	this->received.erase(this->received.begin(), this->received.begin() + n);
+	this->n_simulated += n;
+}
+
+void InputLatency::presented (const ClockTime t)
+{
+	for (const ClockTime& tinput : this->simulated) {
+		const float latency = ClockDuration_to_float(t - tinput);
+		const uint32_t bucket = std::min( static_cast<uint32_t>(latency * 1000.0f), n_buckets - 1 );
+
+		this->histogram[bucket]++;
+		this->total += latency;
+		this->max = std::max(this->max, latency);
+		this->n_presented++;
+	}
+
+	this->simulated.clear();
+}
+
+void InputLatency::report (std::ostream& out, const FrameStats::Format format) const
+{
+	// upper bound of the bucket that contains the percentile p, but not above the max, in ms
+	auto percentile = [this] (const float p) -> float {
+		const uint64_t target = static_cast<uint64_t>( p * static_cast<float>(this->n_presented - 1) );
+		uint64_t count = 0;
+
+		for (uint32_t i = 0; i < n_buckets; i++) {
+			count += this->histogram[i];
+
+			if (count > target)
+				return std::min(static_cast<float>(i + 1), this->max * 1000.0f);
+		}
+
+		return this->max * 1000.0f;
+	};
+
+	const bool empty = (this->n_presented == 0);
+	const Percentiles r = {
+		.p50 = empty ? 0.0f : percentile(0.50f),
+		.p95 = empty ? 0.0f : percentile(0.95f),
+		.p99 = empty ? 0.0f : percentile(0.99f),
+		.max = this->max * 1000.0f
+		};
+	const double mean = empty ? 0.0 : (this->total * 1000.0 / static_cast<double>(this->n_presented));
+
+	switch (format) {
+		case FrameStats::Format::Text:
+			out << "input to present latency (" << this->n_presented << " inputs, in ms, percentiles with 1 ms resolution)" << std::endl;
+			out << "mean " << mean << "  p50 " << r.p50 << "  p95 " << r.p95 << "  p99 " << r.p99 << "  max " << r.max << std::endl;
+
+			for (uint32_t i = 0; i < n_buckets; i++) {
+				if (this->histogram[i] == 0)
+					continue;
+
+				out << std::setw(4) << i << ((i == n_buckets - 1) ? "+ ms " : "  ms ") << std::setw(8) << this->histogram[i] << std::endl;
+			}
+		break;
+
+		case FrameStats::Format::Csv:
+			out << "latency_ms,inputs" << std::endl;
+
+			for (uint32_t i = 0; i < n_buckets; i++)
+				out << i << ',' << this->histogram[i] << std::endl;
+		break;
+
+		case FrameStats::Format::Json:
+			out << "{\"inputs\": " << this->n_presented << ", \"mean_ms\": " << mean
+				<< ", \"p50_ms\": " << r.p50 << ", \"p95_ms\": " << r.p95 << ", \"p99_ms\": " << r.p99 << ", \"max_ms\": " << r.max
+				<< ", \"histogram_1ms\": [";
+
+			for (uint32_t i = 0; i < n_buckets; i++)
+				out << (i ? ", " : "") << this->histogram[i];
+
+			out << "]}" << std::endl;
+		break;
+	}
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
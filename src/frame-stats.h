@@ -0,0 +1,131 @@
+#ifndef __PACMAN_SDL_OPENGL_FRAME_STATS_HEADER_H__
+#define __PACMAN_SDL_OPENGL_FRAME_STATS_HEADER_H__
+
+#include <array>
+#include <vector>
+#include <ostream>
+#include <utility>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "lib.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Keeps the duration of each phase of the last n_frames frames
+	in a ring buffer, so that we can report percentiles per phase.
+*/
+
+class FrameStats
+{
+public:
+	#define _MYLIB_ENUM_CLASS_PHASE_VALUES_ \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(WaitNextFrame) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(TimerTriggers) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(ProcessEvents) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(Physics) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(WorldRender) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(RendererRender) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(UpdateScreen) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(Sleep) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(Spin) \
+		_MYLIB_ENUM_CLASS_PHASE_VALUE_(Frame)   // whole frame, must be the last one
+
+	enum class Phase : uint32_t {
+		#define _MYLIB_ENUM_CLASS_PHASE_VALUE_(V) V,
+		_MYLIB_ENUM_CLASS_PHASE_VALUES_
+		#undef _MYLIB_ENUM_CLASS_PHASE_VALUE_
+	};
+
+	enum class Format {
+		Text,
+		Csv,
+		Json
+	};
+
+	static constexpr uint32_t n_phases = std::to_underlying(Phase::Frame) + 1;
+	static constexpr uint32_t n_frames = 4096; // size of the ring buffer
+
+protected:
+	// samples[phase][frame], in seconds
+	std::array< std::array<float, n_frames>, n_phases > samples;
+	std::array<float, n_phases> current_frame;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_recorded_frames)
+
+public:
+	FrameStats ();
+
+	inline void add (const Phase phase, const ClockDuration duration)
+	{
+		this->current_frame[ std::to_underlying(phase) ] += ClockDuration_to_float(duration);
+	}
+
+	// stores the current frame in the ring buffer and starts a new one
+	void end_frame ();
+
+	void report (std::ostream& out, const Format format) const;
+
+	static const char* enum_class_to_str (const Phase value);
+};
+
+// ---------------------------------------------------
+
+/*
+	Measures the time from the moment the game receives a move input
+	to the end of the update_screen of the first frame that shows it,
+	that is, the first frame rendered after a physics step that
+	simulated the input.
+	The latencies go to a histogram with buckets of 1 ms.
+	The time an input waits in the OS before the event loop pumps it
+	is not known, so it is not included.
+*/
+
+class InputLatency
+{
+public:
+	static constexpr uint32_t n_buckets = 128; // the last one also counts everything above it
+
+protected:
+	std::vector<ClockTime> received; // not simulated yet
+	std::vector<ClockTime> simulated; // not presented yet
+	uint64_t n_simulated;
+	std::array<uint64_t, n_buckets> histogram;
+	double total; // in seconds
+	float max; // in seconds
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_presented)
+
+public:
+	InputLatency ();
+
+	inline void input_received (const ClockTime t)
+	{
+		this->received.push_back(t);
+	}
+
+	// after a physics step, all the inputs received so far are simulated
+	inline void physics_done ()
+	{
+		this->inputs_simulated(this->n_simulated + this->received.size());
+	}
+
+	// the first n_total inputs ever received are simulated
+	void inputs_simulated (const uint64_t n_total);
+
+	// after update_screen
+	void presented (const ClockTime t);
+
+	void report (std::ostream& out, const FrameStats::Format format) const;
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
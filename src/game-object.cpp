@@ -2,8 +2,10 @@
 #include <array>
 #include <limits>
 #include <algorithm>
+#include <type_traits>
 
 #include <cmath>
+#include <cstring>
 
 #include "debug.h"
 #include "game-world.h"
@@ -30,7 +32,7 @@ Game::Player::Player (World *world_)
 	//this->color = this->base_color;
 	this->color = Color(0.0f, 1.0f, 0.0f, 1.0f);
 
-	this->event_move_d = Events::move.subscribe( Mylib::Event::make_callback_object<Events::Move::Type>(*this, &Player::event_move) );
+	this->event_move_d = this->world->get_ref_context().move.subscribe( Mylib::Event::make_callback_object<Events::Move::Type>(*this, &Player::event_move) );
 
 	dprintln("player created");
 }
@@ -38,7 +40,7 @@ Game::Player::Player (World *world_)
 Game::Player::~Player ()
 {
 //	Events::keydown.unsubscribe(this->event_keydown_d);
-	Events::move.unsubscribe(this->event_move_d);
+	this->world->get_ref_context().move.unsubscribe(this->event_move_d);
 }
 
 void Game::Player::physics (const float dt, const Uint8 *keys)
@@ -47,15 +49,15 @@ void Game::Player::physics (const float dt, const Uint8 *keys)
 	const Vector dist = cell_center - this->pos;
 	const float dist_x = std::abs(dist.x);
 	const float dist_y = std::abs(dist.y);
-	const int32_t xi = static_cast<uint32_t>( this->get_x() );
-	const int32_t yi = static_cast<uint32_t>( this->get_y() );
-	const Map& map = this->world->get_ref_map();
+	const uint32_t xi = static_cast<uint32_t>( this->get_x() );
+	const uint32_t yi = static_cast<uint32_t>( this->get_y() );
+	const uint8_t exits = this->world->get_ref_map().get_exits(xi, yi);
 
 	switch (this->target_direction) {
 		using enum Direction;
 
 		case Left:
-			if (dist_y < Config::pacman_turn_threshold && map[yi, xi-1] != Map::Cell::Wall) {
+			if (dist_y < Config::pacman_turn_threshold && (exits & Map::exit_left)) {
 				this->pos.y = cell_center.y; // teleport to center of cell
 				this->vel.x = -Config::pacman_speed;
 				this->vel.y = 0.0f;
@@ -64,7 +66,7 @@ void Game::Player::physics (const float dt, const Uint8 *keys)
 		break;
 
 		case Right:
-			if (dist_y < Config::pacman_turn_threshold && map[yi, xi+1] != Map::Cell::Wall) {
+			if (dist_y < Config::pacman_turn_threshold && (exits & Map::exit_right)) {
 				this->pos.y = cell_center.y; // teleport to center of cell
 				this->vel.x = Config::pacman_speed;
 				this->vel.y = 0.0f;
@@ -73,7 +75,7 @@ void Game::Player::physics (const float dt, const Uint8 *keys)
 		break;
 
 		case Up:
-			if (dist_x < Config::pacman_turn_threshold && map[yi-1, xi] != Map::Cell::Wall) {
+			if (dist_x < Config::pacman_turn_threshold && (exits & Map::exit_up)) {
 				this->pos.x = cell_center.x; // teleport to center of cell
 				this->vel.x = 0.0f;
 				this->vel.y = -Config::pacman_speed;
@@ -82,7 +84,7 @@ void Game::Player::physics (const float dt, const Uint8 *keys)
 		break;
 
 		case Down:
-			if (dist_x < Config::pacman_turn_threshold && map[yi+1, xi] != Map::Cell::Wall) {
+			if (dist_x < Config::pacman_turn_threshold && (exits & Map::exit_down)) {
 				this->pos.x = cell_center.x; // teleport to center of cell
 				this->vel.x = 0.0f;
 				this->vel.y = Config::pacman_speed;
@@ -96,10 +98,10 @@ void Game::Player::physics (const float dt, const Uint8 *keys)
 	this->Object::physics(dt, keys);
 }
 
-void Game::Player::render (const float dt)
+void Game::Player::render (const float alpha, std::vector<CircleInstance>& circles)
 {
 	this->update_color();
-	renderer->draw_circle2D(this->shape, this->pos, this->color);
+	circles.push_back( CircleInstance { .pos = this->get_render_pos(alpha), .radius = this->shape.get_radius(), .color = this->color } );
 }
 
 void Game::Player::event_move (const Events::Move::Type& move_data)
@@ -109,19 +111,14 @@ void Game::Player::event_move (const Events::Move::Type& move_data)
 
 void Game::Player::update_color ()
 {
-	float min_distance = std::numeric_limits<float>::max();
 	const float w = this->world->get_w();
 	const float h = this->world->get_h();
 	const float max_world_distance = std::sqrt(w*w + h*h);
+	const uint32_t nearest = this->world->find_nearest_ghost(this->pos);
 
-	//dprintln("min_distance: " << min_distance)
-
-	for (const Ghost& ghost : this->world->get_ref_ghosts()) {
-		const float distance = Mylib::Math::distance(this->get_value_pos(), ghost.get_value_pos());
-
-		if (distance < min_distance)
-			min_distance = distance;
-	}
+	const float min_distance = (nearest == SpatialGrid::none)
+	                         ? std::numeric_limits<float>::max()
+	                         : Mylib::Math::distance(this->pos, this->world->get_ref_ghosts().get_pos(nearest));
 
 	const float dist_ratio = min_distance / max_world_distance;
 
@@ -138,159 +135,405 @@ void Game::Player::update_color ()
 //	dprintln("min_distance: " << min_distance << "  max_world_distance: " << max_world_distance << "  color.r: " << this->color.r)
 }
 
-Game::Ghost::Ghost (World *world_)
-	: Object(world_),
+Game::Ghosts::Ghosts (World *world_)
+	: world(world_),
 	  shape(Config::ghost_radius)
 {
-	static uint32_t ghost_i = 0;
+	/*
+		All ghosts change color at the same time,
+		so we need a single timer event for all of them.
+	*/
 
-	this->name = "Ghost_" + std::to_string(ghost_i++);
-	this->pos = Vector(0.0f, 0.0f);
-	this->vel = Vector(0.0f, 0.0f);
-	this->direction = Direction::Stopped;
-	this->time_last_turn = this->world->get_time_create();
-	this->time_between_turns = float_to_ClockDuration(Config::ghost_time_between_turns);
+	Events::Timer& timer = this->world->get_ref_context().timer;
 
-	this->color = Color(0.0f, 0.0f, 0.0f, 1.0f);
+	this->event_timer_color_d = timer.schedule_event(timer.get_current_time() + float_to_ClockDuration(Config::ghost_color_change_time), [this] (Events::Timer::Event& event) { this->change_colors(event); });
+}
 
-	this->event_wall_collision_d = Events::wall_collision.subscribe( Mylib::Event::make_callback_object<Events::WallCollision::Type>(*this, &Ghost::collided_with_wall) );
+Game::Ghosts::~Ghosts ()
+{
+	this->world->get_ref_context().timer.unschedule_event(this->event_timer_color_d);
+}
 
-	/*
-		Let's change ghost colors randomly using a coroutine lambda.
-	*/
-	auto coro = [] (Ghost& ghost) -> Mylib::Coroutine {
-		dprintln("Ghost ", ghost.name, " coroutine started");
+void Game::Ghosts::reserve (const uint32_t n)
+{
+	this->x.reserve(n);
+	this->y.reserve(n);
+	this->prev_x.reserve(n);
+	this->prev_y.reserve(n);
+	this->vx.reserve(n);
+	this->vy.reserve(n);
+	this->direction.reserve(n);
+	this->color.reserve(n);
+	this->time_since_turn.reserve(n);
+}
 
-		constexpr ClockDuration wait_time = float_to_ClockDuration(Config::ghost_color_change_time);
+void Game::Ghosts::add (const Vector& pos)
+{
+	this->x.push_back(pos.x);
+	this->y.push_back(pos.y);
+	this->prev_x.push_back(pos.x);
+	this->prev_y.push_back(pos.y);
+	this->vx.push_back(0.0f);
+	this->vy.push_back(0.0f);
+	this->direction.push_back(Direction::Stopped);
+	this->color.push_back( Color(0.0f, 0.0f, 0.0f, 1.0f) );
+	this->time_since_turn.push_back(0.0f);
+}
 
-		std::uniform_real_distribution<float> d (0.0f, 1.0f);
-		auto& r = probability.get_ref_rgenerator();
+void Game::Ghosts::change_colors (Events::Timer::Event& event)
+{
+	const Random& random = this->world->get_ref_random();
+	const uint64_t tick = this->world->get_n_ticks();
+	const uint32_t n = this->size();
 
-		while (true) {
-			co_await Events::timer.coroutine_wait(wait_time);
+	for (uint32_t i = 0; i < n; i++) {
+		const Random::Numbers r = random.get(Random::Stream::GhostColor, i, tick);
+		this->color[i] = Color(Random::to_float(r[0]), Random::to_float(r[1]), Random::to_float(r[2]), 1.0f);
+	}
 
-			ghost.color = Color(d(r), d(r), d(r), 1.0f);
-		}
-	}(*this);
+	event.re_schedule = true;
+	event.time = this->world->get_ref_context().timer.get_current_time() + float_to_ClockDuration(Config::ghost_color_change_time);
+}
+
+size_t Game::Ghosts::get_state_size () const
+{
+	return static_cast<size_t>(this->size()) * (7 * sizeof(float) + sizeof(Color) + sizeof(Direction));
+}
 
-	Mylib::initialize_coroutine(coro);
+/*
+	The arrays are trivially copyable, so saving and restoring
+	them is one memcpy per array.
+	The wall hits are not saved, they were already published.
+*/
 
-	dprintln("ghost created");
+void Game::Ghosts::save_state (uint8_t *data) const
+{
+	auto save = [&data] (const auto& v) {
+		static_assert(std::is_trivially_copyable_v< typename std::remove_cvref_t<decltype(v)>::value_type >);
+
+		const size_t n_bytes = v.size() * sizeof(v[0]);
+
+		std::memcpy(data, v.data(), n_bytes);
+		data += n_bytes;
+	};
+
+	save(this->x);
+	save(this->y);
+	save(this->prev_x);
+	save(this->prev_y);
+	save(this->vx);
+	save(this->vy);
+	save(this->time_since_turn);
+	save(this->color);
+	save(this->direction);
 }
 
-Game::Ghost::~Ghost ()
+void Game::Ghosts::restore_state (const uint8_t *data)
 {
-	Events::wall_collision.unsubscribe(this->event_wall_collision_d);
+	auto restore = [&data] (auto& v) {
+		const size_t n_bytes = v.size() * sizeof(v[0]);
+
+		std::memcpy(v.data(), data, n_bytes);
+		data += n_bytes;
+	};
+
+	restore(this->x);
+	restore(this->y);
+	restore(this->prev_x);
+	restore(this->prev_y);
+	restore(this->vx);
+	restore(this->vy);
+	restore(this->time_since_turn);
+	restore(this->color);
+	restore(this->direction);
+
+	this->wall_hits.clear();
 }
 
-void Game::Ghost::collided_with_wall (const Events::WallCollision::Type& event)
+Game::ClockTime Game::Ghosts::get_color_change_time () const
 {
-	if (&event.coll_obj != this)
-		return;
+	return this->world->get_ref_context().timer.get_event_time(this->event_timer_color_d);
+}
 
-	this->time_last_turn = this->world->get_time_create();
+void Game::Ghosts::set_color_change_time (const ClockTime time)
+{
+	Events::Timer& timer = this->world->get_ref_context().timer;
 
-//	dprintln("------- Ghost " << this->name << " collided with wall")
+	timer.unschedule_event(this->event_timer_color_d);
+	this->event_timer_color_d = timer.schedule_event(time, [this] (Events::Timer::Event& event) { this->change_colors(event); });
 }
 
-void Game::Ghost::physics (const float dt, const Uint8 *keys)
+/*
+	Ghosts don't interact with each other during physics, so each chunk
+	of ghosts is simulated independently, possibly in another thread.
+	The random numbers of a ghost depend only on the seed, the ghost
+	and the tick, so the ghosts take the same decisions no matter
+	how many threads we have or which worker runs each chunk.
+*/
+
+template <typename Tfunc>
+void Game::Ghosts::for_each_chunk (Tfunc&& func)
 {
-	const Vector cell_center = get_cell_center(this->pos);
-	const Vector dist = cell_center - this->pos;
-	const float dist_x = std::abs(dist.x);
-	const float dist_y = std::abs(dist.y);
-	const int32_t xi = static_cast<uint32_t>( this->get_x() );
-	const int32_t yi = static_cast<uint32_t>( this->get_y() );
-	const Map& map = this->world->get_ref_map();
+	const uint32_t n = this->size();
+	const uint32_t n_chunks = this->get_n_chunks();
+	ThreadPool *pool = this->world->get_thread_pool();
+
+	this->chunks.resize(n_chunks);
+
+	auto run_chunk = [this, &func, n] (const uint32_t chunk_i, const uint32_t worker_id) {
+		const uint32_t begin = chunk_i * Config::ghost_chunk_size;
+		const uint32_t end = std::min(begin + Config::ghost_chunk_size, n);
+
+		func(this->chunks[chunk_i], begin, end);
+	};
+
+	if (pool != nullptr)
+		pool->parallel_for(n_chunks, run_chunk);
+	else {
+		for (uint32_t chunk_i = 0; chunk_i < n_chunks; chunk_i++)
+			run_chunk(chunk_i, 0);
+	}
+
+	// merge in chunk order, so that the wall hits are sorted by ghost
+	this->wall_hits.clear();
+
+	for (const Chunk& chunk : this->chunks)
+		this->wall_hits.insert(this->wall_hits.end(), chunk.wall_hits.begin(), chunk.wall_hits.end());
+}
+
+void Game::Ghosts::physics (const float dt)
+{
+	this->for_each_chunk([this, dt] (Chunk& chunk, const uint32_t begin, const uint32_t end) {
+		this->physics_chunk(chunk, begin, end, dt);
+	});
+}
+
+void Game::Ghosts::move_and_collide (const float dt)
+{
+	this->for_each_chunk([this, dt] (Chunk& chunk, const uint32_t begin, const uint32_t end) {
+		this->integrate(begin, end, dt);
+		this->solve_wall_collisions(chunk, begin, end);
+	});
+}
+
+void Game::Ghosts::physics_chunk (Chunk& chunk, const uint32_t begin, const uint32_t end, const float dt)
+{
+	std::copy(this->x.begin() + begin, this->x.begin() + end, this->prev_x.begin() + begin);
+	std::copy(this->y.begin() + begin, this->y.begin() + end, this->prev_y.begin() + begin);
+
+	this->find_deciding(chunk, begin, end, dt);
+	this->decide_directions(chunk);
+	this->integrate(begin, end, dt);
+	this->solve_wall_collisions(chunk, begin, end);
+}
+
+/*
+	A ghost can change direction when it is close enough to the center
+	of a cell and enough time has passed since its last turn.
+	The test loop has no branches and no map accesses, so it can be
+	vectorized where floor can (SSE4.1 and, with GCC, -fno-trapping-math).
+	Its flags are then compacted into the list of deciding ghosts,
+	in a scalar loop without branches.
+*/
+
+void Game::Ghosts::find_deciding (Chunk& chunk, const uint32_t begin, const uint32_t end, const float dt)
+{
+	// indexed from the beginning of the chunk
+	const float *px = this->x.data() + begin;
+	const float *py = this->y.data() + begin;
+	float *time_since_turn = this->time_since_turn.data() + begin;
+	const uint32_t n = end - begin;
+
+	// resizing keeps the capacity, so nothing is allocated after the first steps
+	chunk.can_decide.resize(n);
+	chunk.deciding.resize(n);
 
-	// check if we are in an intersection
-	if (dist_x < Config::pacman_turn_threshold && dist_y < Config::pacman_turn_threshold) {
-		if (Clock::now() > (this->time_last_turn + this->time_between_turns)) {
-			this->time_last_turn = Clock::now();
+	uint8_t *can_decide = chunk.can_decide.data();
+	uint32_t *deciding = chunk.deciding.data();
 
-			// let's check in which adjacent tiles we have walls
+	for (uint32_t j = 0; j < n; j++)
+		time_since_turn[j] += dt;
 
-			std::array<Direction, 4> possibilities; // max of 4 possible directions
-			uint32_t n_possibilities = 0;
+	for (uint32_t j = 0; j < n; j++) {
+		const float dist_x = std::abs(get_cell_center(px[j]) - px[j]);
+		const float dist_y = std::abs(get_cell_center(py[j]) - py[j]);
+		const bool at_intersection = (dist_x < Config::pacman_turn_threshold) & (dist_y < Config::pacman_turn_threshold);
+		const bool can_turn = time_since_turn[j] >= Config::ghost_time_between_turns;
 
-			if (map[xi-1, yi] == Map::Cell::Empty)
-				possibilities[n_possibilities++] = Direction::Left;
-			if (map[xi+1, yi] == Map::Cell::Empty)
-				possibilities[n_possibilities++] = Direction::Right;
-			if (map[xi, yi-1] == Map::Cell::Empty)
-				possibilities[n_possibilities++] = Direction::Up;
-			if (map[xi, yi+1] == Map::Cell::Empty)
-				possibilities[n_possibilities++] = Direction::Down;
+		can_decide[j] = static_cast<uint8_t>(at_intersection & can_turn);
+	}
 
-			//dprint("Ghost n_possibilities = " << n_possibilities << " (")
+	// every ghost is written, but only the deciding ones advance the end of the list
+	uint32_t n_deciding = 0;
 
-			//for (uint32_t i=0; i<n_possibilities; i++)
-			//	dprint( get_direction_str(possibilities[i]) << ", " )
-			
-			//dprint( ")" << std::endl)
+	for (uint32_t j = 0; j < n; j++) {
+		deciding[n_deciding] = begin + j;
+		n_deciding += can_decide[j];
+	}
 
-			if (n_possibilities == 0) // ghost is locked in a jail
-				return;
+	chunk.deciding.resize(n_deciding);
+}
 
+void Game::Ghosts::decide_directions (Chunk& chunk)
+{
+	const Map& map = this->world->get_ref_map();
+	const FlowField& flow_field = this->world->get_ref_flow_field();
+	const Random& random = this->world->get_ref_random();
+	const uint64_t tick = this->world->get_n_ticks();
+	const uint32_t chase_threshold = static_cast<uint32_t>( static_cast<double>(Config::ghost_chase_probability) * 4294967296.0 );
+
+	for (const uint32_t i : chunk.deciding) {
+		const Vector cell_center = get_cell_center(this->get_pos(i));
+		const uint32_t xi = static_cast<uint32_t>( this->x[i] );
+		const uint32_t yi = static_cast<uint32_t>( this->y[i] );
+		const uint8_t exits = map.get_exits(xi, yi);
+
+		this->time_since_turn[i] = 0.0f;
+
+		// let's check in which adjacent tiles we don't have walls
+
+		std::array<Direction, 4> possibilities; // max of 4 possible directions
+		uint32_t n_possibilities = 0;
+
+		if (exits & Map::exit_left)
+			possibilities[n_possibilities++] = Direction::Left;
+		if (exits & Map::exit_right)
+			possibilities[n_possibilities++] = Direction::Right;
+		if (exits & Map::exit_up)
+			possibilities[n_possibilities++] = Direction::Up;
+		if (exits & Map::exit_down)
+			possibilities[n_possibilities++] = Direction::Down;
+
+		if (n_possibilities == 0) // ghost is locked in a jail
+			continue;
+
+		const Random::Numbers r = random.get(Random::Stream::GhostDirection, i, tick);
+		const Direction chase_direction = flow_field.get_direction(xi, yi);
+		Direction target_direction;
+
+		if (chase_direction != Direction::Stopped && r[1] < chase_threshold) {
+			// follow the shortest path to pacman
+			target_direction = chase_direction;
+		}
+		else {
 			// let's randomize a direction among the possible directions
 
 			uint32_t dice_range = n_possibilities - 1;
-			
+
 			// used to reduce the probability of constantly changing direction when moving
-			if (this->direction != Direction::Stopped)
+			if (this->direction[i] != Direction::Stopped)
 				dice_range += 3;
-			
-			//dprintln("Ghost dice_range = " << dice_range)
-
-			std::uniform_int_distribution<uint32_t> distribution (0, dice_range);
-			const uint32_t dice = distribution(probability.get_ref_rgenerator());
-			//dprintln("Ghost dice = " << dice)
-			const Direction target_direction = (dice < n_possibilities)
-			                                 ? static_cast<Direction>( possibilities[dice] )
-											 : Direction::Stopped;
-
-			//dprintln("Ghost target_direction = " << get_direction_str(target_direction))
-
-			switch (target_direction) {
-				using enum Direction;
-
-				case Left:
-					this->pos = cell_center; // teleport to center of cell
-					this->vel.x = -Config::pacman_speed;
-					this->vel.y = 0.0f;
-					this->direction = Left;
-				break;
-
-				case Right:
-					this->pos = cell_center; // teleport to center of cell
-					this->vel.x = Config::pacman_speed;
-					this->vel.y = 0.0f;
-					this->direction = Right;
-				break;
-
-				case Up:
-					this->pos = cell_center; // teleport to center of cell
-					this->vel.x = 0.0f;
-					this->vel.y = -Config::pacman_speed;
-					this->direction = Up;
-				break;
-
-				case Down:
-					this->pos = cell_center; // teleport to center of cell
-					this->vel.x = 0.0f;
-					this->vel.y = Config::pacman_speed;
-					this->direction = Down;
-				break;
-
-				case Stopped: break; // clear warnings
-			}
+
+			const uint32_t dice = Random::to_range(r[0], dice_range + 1);
+			target_direction = (dice < n_possibilities)
+			                 ? possibilities[dice]
+			                 : Direction::Stopped;
+		}
+
+		switch (target_direction) {
+			using enum Direction;
+
+			case Left:
+				this->x[i] = cell_center.x; // teleport to center of cell
+				this->y[i] = cell_center.y;
+				this->vx[i] = -Config::pacman_speed;
+				this->vy[i] = 0.0f;
+				this->direction[i] = Left;
+			break;
+
+			case Right:
+				this->x[i] = cell_center.x; // teleport to center of cell
+				this->y[i] = cell_center.y;
+				this->vx[i] = Config::pacman_speed;
+				this->vy[i] = 0.0f;
+				this->direction[i] = Right;
+			break;
+
+			case Up:
+				this->x[i] = cell_center.x; // teleport to center of cell
+				this->y[i] = cell_center.y;
+				this->vx[i] = 0.0f;
+				this->vy[i] = -Config::pacman_speed;
+				this->direction[i] = Up;
+			break;
+
+			case Down:
+				this->x[i] = cell_center.x; // teleport to center of cell
+				this->y[i] = cell_center.y;
+				this->vx[i] = 0.0f;
+				this->vy[i] = Config::pacman_speed;
+				this->direction[i] = Down;
+			break;
+
+			case Stopped: break; // keep the current direction
 		}
 	}
+}
 
-	this->Object::physics(dt, keys);
+void Game::Ghosts::integrate (const uint32_t begin, const uint32_t end, const float dt)
+{
+	float *px = this->x.data();
+	float *py = this->y.data();
+	const float *pvx = this->vx.data();
+	const float *pvy = this->vy.data();
+
+	for (uint32_t i = begin; i < end; i++) {
+		px[i] += pvx[i] * dt;
+		py[i] += pvy[i] * dt;
+	}
+}
+
+/*
+	Same as World::solve_wall_collisions, but for the ghost arrays.
+	After hitting a wall, a ghost is allowed to choose a new direction immediately.
+	The hits are recorded in the chunk, and merged by physics after all chunks are done.
+*/
+
+void Game::Ghosts::solve_wall_collisions (Chunk& chunk, const uint32_t begin, const uint32_t end)
+{
+	const Map& map = this->world->get_ref_map();
+
+	chunk.wall_hits.clear();
+
+	for (uint32_t i = begin; i < end; i++) {
+		const float cell_center_x = get_cell_center(this->x[i]);
+		const float cell_center_y = get_cell_center(this->y[i]);
+		const uint32_t xi = static_cast<uint32_t>( this->x[i] );
+		const uint32_t yi = static_cast<uint32_t>( this->y[i] );
+		const uint8_t exits = map.get_exits(xi, yi);
+		bool collided = false;
+
+		if (this->x[i] < cell_center_x && !(exits & Map::exit_left)) {
+			this->x[i] = cell_center_x;
+			this->vx[i] = 0.0f;
+			collided = true;
+		}
+		else if (this->x[i] > cell_center_x && !(exits & Map::exit_right)) {
+			this->x[i] = cell_center_x;
+			this->vx[i] = 0.0f;
+			collided = true;
+		}
+
+		if (this->y[i] < cell_center_y && !(exits & Map::exit_up)) {
+			this->y[i] = cell_center_y;
+			this->vy[i] = 0.0f;
+			collided = true;
+		}
+		else if (this->y[i] > cell_center_y && !(exits & Map::exit_down)) {
+			this->y[i] = cell_center_y;
+			this->vy[i] = 0.0f;
+			collided = true;
+		}
+
+		if (collided) {
+			chunk.wall_hits.push_back( WallHit { .ghost_id = i, .direction = this->direction[i] } );
+			this->direction[i] = Direction::Stopped;
+			this->time_since_turn[i] = Config::ghost_time_between_turns;
+		}
+	}
 }
 
-void Game::Ghost::render (const float dt)
+void Game::Ghosts::render (const uint32_t i, const float alpha, std::vector<CircleInstance>& circles)
 {
-	renderer->draw_circle2D(this->shape, this->pos, this->color);
+	circles.push_back( CircleInstance { .pos = this->get_render_pos(i, alpha), .radius = this->shape.get_radius(), .color = this->color[i] } );
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <SDL.h>
 
 #include <string>
+#include <vector>
 
 #include <my-lib/std.h>
 #include <my-lib/macros.h>
@@ -18,6 +19,7 @@
 #include "config.h"
 #include "lib.h"
 #include "events.h"
+#include "renderer.h"
 
 
 namespace Game
@@ -25,8 +27,6 @@ namespace Game
 
 // ---------------------------------------------------
 
-using MyGlib::Graphics::Rect2D;
-using MyGlib::Graphics::Circle2D;
 
 // ---------------------------------------------------
 
@@ -42,6 +42,7 @@ public:
 
 protected:
 	MYLIB_OO_ENCAPSULATE_OBJ_WITH_COPY_MOVE(Vector, pos)
+	MYLIB_OO_ENCAPSULATE_OBJ_WITH_COPY_MOVE(Vector, prev_pos) // position in the previous physics step
 	MYLIB_OO_ENCAPSULATE_OBJ_WITH_COPY_MOVE(Vector, vel)
 	MYLIB_OO_ENCAPSULATE_OBJ_WITH_COPY_MOVE(std::string, name)
 	MYLIB_OO_ENCAPSULATE_PTR(World*, world)
@@ -95,8 +96,20 @@ public:
 		this->vel.y = vy;
 	}
 
+	// alpha is in [0, 1] and interpolates between the last two physics steps
+	inline Vector get_render_pos (const float alpha) const
+	{
+		return this->prev_pos + (this->pos - this->prev_pos) * alpha;
+	}
+
 	virtual void physics (const float dt, const Uint8 *keys);
-	virtual void render (const float dt) = 0;
+	// appends the circles of the object to the batch of the frame
+	virtual void render (const float alpha, std::vector<CircleInstance>& circles) = 0;
+
+	// called by the world only for this object, right after it hit a wall
+	virtual void collided_with_wall (const Direction direction)
+	{
+	}
 };
 
 // ---------------------------------------------------
@@ -105,8 +118,8 @@ class Player : public Object
 {
 protected:
 	Circle2D shape;
-	Direction target_direction;
-	Color color;
+	MYLIB_OO_ENCAPSULATE_SCALAR(Direction, target_direction)
+	MYLIB_OO_ENCAPSULATE_OBJ(Color, color)
 	//Graphics::Color base_color;
 	Events::Move::Descriptor event_move_d;
 
@@ -115,7 +128,7 @@ public:
 	~Player ();
 
 	void physics (const float dt, const Uint8 *keys) override final;
-	void render (const float dt) override final;
+	void render (const float alpha, std::vector<CircleInstance>& circles) override final;
 
 	void event_move (const Events::Move::Type& move_data);
 
@@ -124,22 +137,112 @@ public:
 
 // ---------------------------------------------------
 
-class Ghost : public Object
+/*
+	All ghosts are stored in a structure-of-arrays layout, so that
+	the physics of all ghosts is updated by loops over contiguous
+	arrays, without virtual calls or pointer chasing.
+	A ghost is identified by its index in the arrays.
+*/
+
+class Ghosts
 {
+public:
+	using Direction = Events::MoveData::Direction;
+
+	struct WallHit {
+		uint32_t ghost_id;
+		Direction direction; // direction the ghost was moving before hitting the wall
+	};
+
+protected:
+	// scratch data of a chunk of ghosts, reused between steps
+	struct Chunk {
+		std::vector<uint8_t> can_decide; // per ghost of the chunk, 1 if it is in deciding
+		std::vector<uint32_t> deciding; // ghosts that are allowed to choose a new direction in the current step
+		std::vector<WallHit> wall_hits;
+	};
+
+	MYLIB_OO_ENCAPSULATE_PTR(World*, world)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, x)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, y)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, prev_x) // position in the previous physics step
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, prev_y)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, vx)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, vy)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<Direction>, direction)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<Color>, color)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<float>, time_since_turn) // in seconds
+
 protected:
+	// wall hits of the last step, in ghost order
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<WallHit>, wall_hits)
+
 	Circle2D shape;
-	Color color;
-	ClockTime time_last_turn;
-	ClockDuration time_between_turns;
-	Events::WallCollision::Descriptor event_wall_collision_d;
+	Events::Timer::Descriptor event_timer_color_d;
+
+	std::vector<Chunk> chunks;
 
 public:
-	Ghost (World *world_);
-	~Ghost ();
+	Ghosts (World *world_);
+	~Ghosts ();
 
-	void collided_with_wall (const Events::WallCollision::Type& event);
-	void physics (const float dt, const Uint8 *keys) override final;
-	void render (const float dt) override final;
+	inline uint32_t size () const
+	{
+		return static_cast<uint32_t>( this->x.size() );
+	}
+
+	inline Vector get_pos (const uint32_t i) const
+	{
+		return Vector(this->x[i], this->y[i]);
+	}
+
+	// alpha is in [0, 1] and interpolates between the last two physics steps
+	inline Vector get_render_pos (const uint32_t i, const float alpha) const
+	{
+		return Vector(
+			this->prev_x[i] + (this->x[i] - this->prev_x[i]) * alpha,
+			this->prev_y[i] + (this->y[i] - this->prev_y[i]) * alpha
+			);
+	}
+
+	inline uint32_t get_n_chunks () const
+	{
+		return (this->size() + Config::ghost_chunk_size - 1) / Config::ghost_chunk_size;
+	}
+
+	void reserve (const uint32_t n);
+	void add (const Vector& pos);
+
+	void physics (const float dt);
+
+	/*
+		Only moves the ghosts and solves their wall collisions,
+		without any decisions. Used to benchmark the collision pass.
+	*/
+	void move_and_collide (const float dt);
+
+	void render (const uint32_t i, const float alpha, std::vector<CircleInstance>& circles);
+	void change_colors (Events::Timer::Event& event);
+
+	// the arrays of all ghosts, back to back
+	size_t get_state_size () const;
+	void save_state (uint8_t *data) const;
+	void restore_state (const uint8_t *data);
+
+	ClockTime get_color_change_time () const;
+	void set_color_change_time (const ClockTime time);
+
+protected:
+	// runs func(chunk, begin, end) for every chunk and merges their wall hits
+	template <typename Tfunc>
+	void for_each_chunk (Tfunc&& func);
+
+	// these work on the ghosts [begin, end) of a single chunk
+	void physics_chunk (Chunk& chunk, const uint32_t begin, const uint32_t end, const float dt);
+	void find_deciding (Chunk& chunk, const uint32_t begin, const uint32_t end, const float dt);
+	void decide_directions (Chunk& chunk);
+	void integrate (const uint32_t begin, const uint32_t end, const float dt);
+	void solve_wall_collisions (Chunk& chunk, const uint32_t begin, const uint32_t end);
 };
 
 // ---------------------------------------------------
@@ -1,12 +1,24 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <chrono>
 #include <limits>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <bit>
+
+#include <cstring>
+#include <cmath>
 
 #include <my-game-lib/my-game-lib.h>
 
 #include "debug.h"
 #include "game-world.h"
 #include "game-object.h"
+#include "sim-thread.h"
+#include "world-batch.h"
 #include "lib.h"
 
 namespace Game
@@ -21,57 +33,279 @@ void die ()
 
 Map::Map ()
 {
-	this->w = 8;
-	this->h = 8;
-	this->map = Mylib::Matrix<Cell>(this->h, this->w);
-	auto& m = this->map;
-	
-	std::string map_string = "00000000"
-	                         "0p  g  0"
-	                         "0    0 0"
-	                         "0    0 0"
-	                         "0  g   0"
-	                         "0 0000 0"
-	                         "0   g  0"
-	                         "00000000";
+	static constexpr std::string_view map_string = "00000000\n"
+	                                               "0p  g  0\n"
+	                                               "0    0 0\n"
+	                                               "0    0 0\n"
+	                                               "0  g   0\n"
+	                                               "0 0000 0\n"
+	                                               "0   g  0\n"
+	                                               "00000000\n";
+
+	this->parse_text(map_string.data(), map_string.size());
+}
+
+Map::Map (const std::string& fname)
+{
+	const MappedFile file(fname);
+
+	if (file.get_size() >= sizeof(binary_magic) && std::memcmp(file.get_data(), binary_magic, sizeof(binary_magic)) == 0)
+		this->parse_binary(file.get_data(), file.get_size());
+	else
+		this->parse_text(file.get_data(), file.get_size());
+
+	dprintln("loaded map ", fname, " (", this->w, "x", this->h, ", ", this->n_walls, " walls, ", this->ghost_starts.size(), " ghosts)");
+}
+
+Map::Map (const uint32_t w_, const uint32_t h_, const uint32_t n_ghosts)
+{
+	mylib_assert_exception_msg(w_ >= 3 && h_ >= 3, "generated maps must be at least 3x3, got ", w_, "x", h_)
+
+	this->allocate(w_, h_);
+
+	std::vector<TilePos> free_cells;
+
+	for (uint32_t y=0; y<this->h; y++) {
+		for (uint32_t x=0; x<this->w; x++) {
+			const bool border = (x == 0 || y == 0 || x == (this->w - 1) || y == (this->h - 1));
+			const bool pillar = (x % 2 == 0) && (y % 2 == 0);
+
+			if (border || pillar)
+				this->set_cell(x, y, Cell::Wall);
+			else if (x == 1 && y == 1)
+				this->set_cell(x, y, Cell::Pacman_start);
+			else {
+				this->set_cell(x, y, Cell::Empty);
+				free_cells.push_back( TilePos { .x = x, .y = y } );
+			}
+		}
+	}
+
+	mylib_assert_exception_msg(n_ghosts == 0 || !free_cells.empty(), "no free cells for the ghosts in a ", w_, "x", h_, " map")
+
+	const uint64_t n_free = free_cells.size();
+
+	for (uint32_t k = 0; k < n_ghosts; k++) {
+		const uint64_t i = (n_ghosts <= n_free)
+		                 ? (static_cast<uint64_t>(k) * n_free) / n_ghosts
+		                 : (k % n_free);
+		const TilePos& pos = free_cells[i];
+
+		if (this->map[pos.y, pos.x] == Cell::Empty)
+			this->set_cell(pos.x, pos.y, Cell::Ghost_start);
+		else
+			this->ghost_starts.push_back(pos);
+	}
 
-	mylib_assert_exception(map_string.length() == (this->w * this->h))
+	this->finish_loading();
+}
+
+void Map::allocate (const uint32_t w_, const uint32_t h_)
+{
+	mylib_assert_exception_msg(w_ > 0 && h_ > 0, "invalid map size ", w_, "x", h_)
 
+	this->w = w_;
+	this->h = h_;
+	this->map = Mylib::Matrix<Cell>(this->h, this->w);
 	this->n_walls = 0;
 	this->pacman_start_x = std::numeric_limits<uint32_t>::max();
+	this->ghost_starts.clear();
+}
+
+void Map::finish_loading ()
+{
+	mylib_assert_exception_msg(this->pacman_start_x != std::numeric_limits<uint32_t>::max(), "map has no pacman start position")
+
+	this->build_exits();
+}
+
+/*
+	Moving objects only need to know which neighbours are not walls,
+	so we compute it once for every cell, instead of doing up to
+	four map lookups per object per step.
+	Cells outside of the map count as walls.
+*/
+
+void Map::build_exits ()
+{
+	this->exits.assign(static_cast<size_t>(this->w) * static_cast<size_t>(this->h), 0);
 
-	uint32_t k = 0;
 	for (uint32_t y=0; y<this->h; y++) {
 		for (uint32_t x=0; x<this->w; x++) {
-			switch (map_string[k]) {
+			uint8_t e = 0;
+
+			if (x > 0 && this->map[y, x-1] != Cell::Wall)
+				e |= exit_left;
+			if ((x + 1) < this->w && this->map[y, x+1] != Cell::Wall)
+				e |= exit_right;
+			if (y > 0 && this->map[y-1, x] != Cell::Wall)
+				e |= exit_up;
+			if ((y + 1) < this->h && this->map[y+1, x] != Cell::Wall)
+				e |= exit_down;
+
+			if (e != (exit_left | exit_right) && e != (exit_up | exit_down))
+				e |= junction;
+
+			this->exits[y * this->w + x] = e;
+		}
+	}
+}
+
+/*
+	All rows have the same width, so the size of the map is known
+	from the first line and the file size.
+	Then the cells are parsed in a single pass directly from the buffer.
+*/
+
+void Map::parse_text (const char *data, const size_t size)
+{
+	const char *first_eol = static_cast<const char*>( std::memchr(data, '\n', size) );
+	mylib_assert_exception_msg(first_eol != nullptr, "invalid map, no end of line found")
+
+	const bool crlf = (first_eol > data) && (*(first_eol - 1) == '\r');
+	const size_t eol_size = crlf ? 2 : 1;
+	const size_t w_ = static_cast<size_t>(first_eol - data) - (eol_size - 1);
+	const size_t stride = w_ + eol_size;
+
+	// the last line may not have an end of line
+	const size_t h_ = (size + eol_size) / stride;
+
+	mylib_assert_exception_msg(h_ * stride == size || h_ * stride == (size + eol_size), "invalid map, all lines must have width ", w_)
+
+	this->allocate(static_cast<uint32_t>(w_), static_cast<uint32_t>(h_));
+
+	const char *line = data;
+
+	for (uint32_t y=0; y<this->h; y++, line += stride) {
+		for (uint32_t x=0; x<this->w; x++) {
+			switch (line[x]) {
 				case ' ':
-					m[y, x] = Cell::Empty;
+					this->set_cell(x, y, Cell::Empty);
 				break;
-				
+
 				case '0':
-					m[y, x] = Cell::Wall;
-					this->n_walls++;
+					this->set_cell(x, y, Cell::Wall);
 				break;
-				
+
 				case 'p':
-					m[y, x] = Cell::Pacman_start;
-					this->pacman_start_x = x;
-					this->pacman_start_y = y;
+					this->set_cell(x, y, Cell::Pacman_start);
 				break;
 
 				case 'g':
-					m[y, x] = Cell::Ghost_start;
+					this->set_cell(x, y, Cell::Ghost_start);
 				break;
-				
+
 				default:
-					mylib_assert_exception(0)
+					mylib_throw_exception_msg("invalid map character '", line[x], "' at row ", y, " col ", x);
 			}
+		}
+
+		// every line but the last one must end with an end of line
+		if ((line + stride) <= (data + size))
+			mylib_assert_exception_msg(line[stride - 1] == '\n', "invalid map, line ", y, " must have width ", w_)
+	}
+
+	this->finish_loading();
+}
+
+static uint32_t read_uint32_le (const char *data)
+{
+	const auto *b = reinterpret_cast<const uint8_t*>(data);
+
+	return static_cast<uint32_t>(b[0])
+	     | (static_cast<uint32_t>(b[1]) << 8)
+	     | (static_cast<uint32_t>(b[2]) << 16)
+	     | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+static void write_uint32_le (std::ostream& out, const uint32_t v)
+{
+	const char b[4] = {
+		static_cast<char>(v & 0xFF),
+		static_cast<char>((v >> 8) & 0xFF),
+		static_cast<char>((v >> 16) & 0xFF),
+		static_cast<char>((v >> 24) & 0xFF)
+	};
+
+	out.write(b, sizeof(b));
+}
+
+void Map::parse_binary (const char *data, const size_t size)
+{
+	mylib_assert_exception_msg(size >= binary_header_size, "invalid binary map, truncated header")
+
+	const uint32_t version = read_uint32_le(data + 4);
+	mylib_assert_exception_msg(version == binary_version, "unsupported binary map version ", version)
+
+	const uint32_t w_ = read_uint32_le(data + 8);
+	const uint32_t h_ = read_uint32_le(data + 12);
+	const uint64_t n_cells = static_cast<uint64_t>(w_) * static_cast<uint64_t>(h_);
+
+	mylib_assert_exception_msg(size == binary_header_size + ((n_cells + 3) / 4), "invalid binary map, size does not match ", w_, "x", h_)
 
+	this->allocate(w_, h_);
+
+	const auto *cells = reinterpret_cast<const uint8_t*>(data + binary_header_size);
+	uint64_t k = 0;
+
+	for (uint32_t y=0; y<this->h; y++) {
+		for (uint32_t x=0; x<this->w; x++) {
+			const uint32_t shift = static_cast<uint32_t>(k % 4) * 2;
+			this->set_cell(x, y, static_cast<Cell>((cells[k / 4] >> shift) & 0x03));
 			k++;
 		}
 	}
 
-	mylib_assert_exception(this->pacman_start_x != std::numeric_limits<uint32_t>::max())
+	this->finish_loading();
+}
+
+void Map::save_binary (const std::string& fname) const
+{
+	std::ofstream out(fname, std::ios::binary);
+	mylib_assert_exception_msg(out.is_open(), "cannot open ", fname)
+
+	out.write(binary_magic, sizeof(binary_magic));
+	write_uint32_le(out, binary_version);
+	write_uint32_le(out, this->w);
+	write_uint32_le(out, this->h);
+
+	std::vector<uint8_t> cells( (static_cast<uint64_t>(this->w) * static_cast<uint64_t>(this->h) + 3) / 4, 0 );
+	uint64_t k = 0;
+
+	for (uint32_t y=0; y<this->h; y++) {
+		for (uint32_t x=0; x<this->w; x++) {
+			const uint32_t shift = static_cast<uint32_t>(k % 4) * 2;
+			cells[k / 4] |= static_cast<uint8_t>(std::to_underlying(this->map[y, x]) << shift);
+			k++;
+		}
+	}
+
+	out.write(reinterpret_cast<const char*>(cells.data()), static_cast<std::streamsize>(cells.size()));
+
+	mylib_assert_exception_msg(out.good(), "error writing ", fname)
+}
+
+/*
+	64-bit FNV-1a of the size and the cells.
+*/
+
+uint64_t Map::get_hash () const
+{
+	uint64_t hash = 0xCBF29CE484222325;
+
+	auto add = [&hash] (const uint32_t v) {
+		hash = (hash ^ v) * 0x100000001B3;
+	};
+
+	add(this->w);
+	add(this->h);
+
+	for (uint32_t y=0; y<this->h; y++) {
+		for (uint32_t x=0; x<this->w; x++)
+			add( std::to_underlying(this->map[y, x]) );
+	}
+
+	return hash;
 }
 
 Map::~Map ()
@@ -80,10 +314,19 @@ Map::~Map ()
 
 Main::Main ()
 {
+	this->world = nullptr;
+	this->thread_pool = nullptr;
+	this->renderer = nullptr;
+	this->event_manager = nullptr;
+	this->sim_thread = nullptr;
+	this->replay = nullptr;
+	this->recorder = nullptr;
 }
 
 Main::~Main ()
 {
+	delete this->replay;
+	delete this->thread_pool;
 }
 
 void Main::allocate ()
@@ -106,35 +349,90 @@ void Main::load (const InitConfig& cfg)
 
 	this->state = State::initializing;
 	this->cfg_params = cfg;
+	this->frame_pacer = FramePacer(cfg.frame_pacing);
 
-	this->lib = &MyGlib::Lib::init({
-		.graphics_type = cfg.graphics_type,
-		.window_name = "Pacman",
-		.window_width_px = cfg.window_width_px,
-		.window_height_px = cfg.window_height_px,
-		.fullscreen = cfg.fullscreen
-	});
+	if (cfg.headless) {
+		this->lib = nullptr;
+		this->renderer = nullptr;
+		this->event_manager = nullptr;
+	}
+	else if (cfg.offscreen_video == OffscreenVideo::Null) {
+		this->lib = nullptr;
+		this->renderer = new RecordingRenderer(cfg.window_width_px, cfg.window_height_px);
+		this->event_manager = nullptr;
+	}
+	else if (cfg.offscreen_video == OffscreenVideo::Software) {
+		this->lib = nullptr;
+		this->renderer = new SoftwareRenderer(cfg.window_width_px, cfg.window_height_px, cfg.frame_dump_dir, cfg.frame_dump_interval);
+		this->event_manager = nullptr;
+	}
+	else {
+		this->lib = &MyGlib::Lib::init({
+			.graphics_type = cfg.graphics_type,
+			.window_name = "Pacman",
+			.window_width_px = cfg.window_width_px,
+			.window_height_px = cfg.window_height_px,
+			.fullscreen = cfg.fullscreen
+		});
+
+		this->renderer = new MyGlibRenderer(this->lib->get_graphics_manager());
+		this->event_manager = &this->lib->get_event_manager();
+
+		Events::setup_events(*this->event_manager);
+	}
 
-	renderer = &this->lib->get_graphics_manager();
-	event_manager = &this->lib->get_event_manager();
+	dprintln("chorono resolution ", (static_cast<float>(Clock::period::num) / static_cast<float>(Clock::period::den)));
 
-	Events::setup_events();
+	this->thread_pool = new ThreadPool( (cfg.n_threads > 0) ? cfg.n_threads : ThreadPool::get_default_n_workers() );
 
-	dprintln("chorono resolution ", (static_cast<float>(Clock::period::num) / static_cast<float>(Clock::period::den)));
+	dprintln("using ", this->thread_pool->get_n_workers(), " threads");
 
-	this->world = nullptr;
-	this->world = new World();
+	if (!cfg.headless && cfg.offscreen_video == OffscreenVideo::Software)
+		static_cast<SoftwareRenderer*>(this->renderer)->set_thread_pool(this->thread_pool);
+
+	if (!cfg.replay_fname.empty())
+		this->replay = new Replay(cfg.replay_fname);
+
+	const uint64_t seed = (this->replay != nullptr) ? this->replay->get_seed() : cfg.seed.value_or( Random::make_seed() );
+
+	dprintln("seed ", seed);
+
+	this->world = new World(cfg.map_fname, seed);
+	this->world->set_thread_pool(this->thread_pool);
+	this->world->set_zoom(cfg.zoom);
+	this->world->get_ref_context().renderer = this->renderer;
+	this->world->get_ref_context().event_manager = this->event_manager;
+
+	if (this->replay != nullptr)
+		mylib_assert_exception_msg(this->replay->get_map_hash() == this->world->get_ref_map().get_hash(), "the replay ", cfg.replay_fname, " was recorded with another map")
+
+	if (!cfg.record_fname.empty())
+		this->recorder = new ReplayRecorder(*this->world, cfg.headless ? cfg.headless_dt : Config::sim_dt);
 
 	dprintln("loaded world");
 
 	this->alive = true;
 
-	this->event_quit_d = event_manager->quit().subscribe( Mylib::Event::make_callback_object<MyGlib::Event::Quit::Type>(*this, &Main::event_quit) );
+	if (this->lib != nullptr)
+		this->event_quit_d = this->event_manager->quit().subscribe( Mylib::Event::make_callback_object<MyGlib::Event::Quit::Type>(*this, &Main::event_quit) );
 }
 
 void Main::cleanup ()
 {
-	event_manager->quit().unsubscribe(this->event_quit_d);
+	if (this->recorder != nullptr) {
+		this->recorder->save(this->cfg_params.record_fname);
+		delete this->recorder;
+		this->recorder = nullptr;
+	}
+
+	delete this->renderer;
+	this->renderer = nullptr;
+
+	if (this->lib == nullptr)
+		return;
+
+	this->event_manager->quit().unsubscribe(this->event_quit_d);
+
 	MyGlib::Lib::quit();
 }
 
@@ -147,6 +445,25 @@ void Main::run ()
 {
 	const Uint8 *keys;
 	float real_dt, virtual_dt, required_dt, sleep_dt, busy_wait_dt, fps;
+	float accumulator, alpha;
+	uint32_t n_steps;
+	const float target_dt = 1.0f / this->cfg_params.target_fps;
+	const ClockDuration frame_duration = float_to_ClockDuration(target_dt);
+
+	if (this->cfg_params.headless) {
+		if (this->replay != nullptr)
+			this->run_replay();
+		else if (this->cfg_params.batch_worlds > 0)
+			this->run_batch();
+		else
+			this->run_headless();
+		return;
+	}
+
+	if (this->cfg_params.offscreen_video != OffscreenVideo::None) {
+		this->run_offscreen();
+		return;
+	}
 
 	this->state = State::playing;
 
@@ -158,90 +475,368 @@ void Main::run ()
 	sleep_dt = 0.0f;
 	busy_wait_dt = 0.0f;
 	fps = 0.0f;
+	accumulator = 0.0f;
+
+	if (this->cfg_params.threaded_sim)
+		this->sim_thread = new SimulationThread(*this->world);
 
 	while (this->alive) {
 		const ClockTime tbegin = Clock::now();
 		ClockTime tend;
 		ClockDuration elapsed;
+		ClockTime tphase = tbegin;
 
-		renderer->wait_next_frame();
+		// adds the time since the end of the previous phase to the given phase
+		auto end_phase = [this, &tphase] (const FrameStats::Phase phase) {
+			const ClockTime t = Clock::now();
+			this->frame_stats.add(phase, t - tphase);
+			tphase = t;
+		};
 
-		Events::timer.trigger_events();
+		this->renderer->wait_next_frame();
+		end_phase(FrameStats::Phase::WaitNextFrame);
 
+		// if fps gets lower than min_fps, we slow down the simulation
 		virtual_dt = (real_dt > Config::max_dt) ? Config::max_dt : real_dt;
+		accumulator += virtual_dt;
 
 	#if 0
-		dprintln("start new frame render target_dt=", Config::target_dt,
+		dprintln("start new frame render target_dt=", target_dt,
 			" required_dt=", required_dt,
 			" real_dt=", real_dt,
 			" sleep_dt=", sleep_dt,
 			" busy_wait_dt=", busy_wait_dt,
 			" virtual_dt=", virtual_dt,
 			" max_dt=", Config::max_dt,
-			" target_dt=", Config::target_dt,
-			" fps=", fps
+			" target_dt=", target_dt,
+			" fps=", fps,
+			" accumulator=", accumulator
 			);
 	#endif
 
-		event_manager->process_events();
+		if (!this->cfg_params.late_input || this->sim_thread != nullptr) {
+			this->event_manager->process_events();
+			end_phase(FrameStats::Phase::ProcessEvents);
+		}
 
 		switch (this->state) {
 			case State::playing:
-				this->world->physics(virtual_dt, keys);
-				this->world->render(virtual_dt);
+				if (this->sim_thread != nullptr) {
+					const World::Snapshot& snapshot = this->sim_thread->acquire_snapshot();
+
+					this->input_latency.inputs_simulated(snapshot.n_inputs);
+
+					// we render one step behind the simulation, interpolating the last two steps
+					alpha = std::clamp(ClockDuration_to_float(Clock::now() - snapshot.time) / Config::sim_dt, 0.0f, 1.0f);
+
+					this->world->render_snapshot(snapshot, alpha);
+					end_phase(FrameStats::Phase::WorldRender);
+					break;
+				}
+
+				/*
+					The simulation always advances in steps of Config::sim_dt,
+					independently of the frame rate.
+					The time that is left in the accumulator is used to
+					interpolate the rendering between the last two steps.
+				*/
+
+				n_steps = 0;
+
+				while (accumulator >= Config::sim_dt && n_steps < Config::max_sim_steps_per_frame) {
+					this->world->advance_time(Config::sim_dt);
+					end_phase(FrameStats::Phase::TimerTriggers);
+
+					// the input that arrived during the timers still makes it to this step
+					if (this->cfg_params.late_input) {
+						this->event_manager->process_events();
+						end_phase(FrameStats::Phase::ProcessEvents);
+					}
+
+					this->world->physics(Config::sim_dt, keys);
+					end_phase(FrameStats::Phase::Physics);
+
+					this->input_latency.physics_done();
+
+					accumulator -= Config::sim_dt;
+					n_steps++;
+				}
+
+				// no step in this frame, but we still need to see the quit event
+				if (this->cfg_params.late_input && n_steps == 0) {
+					this->event_manager->process_events();
+					end_phase(FrameStats::Phase::ProcessEvents);
+				}
+
+				// we could not catch up, so we drop the remaining time
+				if (accumulator > Config::sim_dt)
+					accumulator = Config::sim_dt;
+
+				alpha = accumulator / Config::sim_dt;
+
+				this->world->render(alpha);
+				end_phase(FrameStats::Phase::WorldRender);
 			break;
 			
 			default:
 				mylib_assert_exception(0)
 		}
 
-		renderer->render();
-		renderer->update_screen();
+		this->renderer->render();
+		end_phase(FrameStats::Phase::RendererRender);
+
+		this->renderer->update_screen();
+		end_phase(FrameStats::Phase::UpdateScreen);
+
+		this->input_latency.presented(tphase);
 
 		const ClockTime trequired = Clock::now();
 		elapsed = trequired - tbegin;
 		required_dt = ClockDuration_to_float(elapsed);
 
-		if constexpr (Config::sleep_to_save_cpu) {
-			if (required_dt < Config::sleep_threshold) {
-				sleep_dt = Config::sleep_threshold - required_dt; // target sleep time
-				const uint32_t delay = static_cast<uint32_t>(sleep_dt * 1000.0f);
-				//dprintln( "sleeping for " << delay << "ms..." )
-				SDL_Delay(delay);
-			}
-		}
-		
-		const ClockTime tbefore_busy_wait = Clock::now();
-		elapsed = tbefore_busy_wait - trequired;
-		sleep_dt = ClockDuration_to_float(elapsed); // check exactly time sleeping
-
-		do {
-			tend = Clock::now();
-			elapsed = tend - tbegin;
-			real_dt = ClockDuration_to_float(elapsed);
+		// exact pacing is not required to keep the simulation speed,
+		// since the accumulator absorbs the jitter of the sleep
 
-			if constexpr (!Config::busy_wait_to_ensure_fps)
-				break;
-		} while (real_dt < Config::target_dt);
+		const FramePacer::Wait wait = this->frame_pacer.wait_until(tbegin + frame_duration);
 
-		elapsed = tend - tbefore_busy_wait;
-		busy_wait_dt = ClockDuration_to_float(elapsed);
+		tend = Clock::now();
+		elapsed = tend - tbegin;
+		real_dt = ClockDuration_to_float(elapsed);
+		sleep_dt = ClockDuration_to_float(wait.sleep);
+		busy_wait_dt = ClockDuration_to_float(wait.spin);
 
 		fps = 1.0f / real_dt;
+
+		this->frame_stats.add(FrameStats::Phase::Sleep, wait.sleep);
+		this->frame_stats.add(FrameStats::Phase::Spin, tend - trequired - wait.sleep);
+		this->frame_stats.add(FrameStats::Phase::Frame, tend - tbegin);
+		this->frame_stats.end_frame();
+	}
+
+	delete this->sim_thread;
+	this->sim_thread = nullptr;
+
+	if (this->cfg_params.frame_stats)
+		this->report_frame_stats();
+}
+
+void Main::report_frame_stats ()
+{
+	if (this->cfg_params.frame_stats_fname.empty()) {
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(3);
+		this->frame_stats.report(out, this->cfg_params.frame_stats_format);
+		this->input_latency.report(out, this->cfg_params.frame_stats_format);
+		this->frame_pacer.report(out);
+		dprint(out.str());
+	}
+	else {
+		std::ofstream out(this->cfg_params.frame_stats_fname);
+		mylib_assert_exception_msg(out.is_open(), "cannot open ", this->cfg_params.frame_stats_fname)
+		out << std::fixed << std::setprecision(3);
+		this->frame_stats.report(out, this->cfg_params.frame_stats_format);
+		this->input_latency.report(out, this->cfg_params.frame_stats_format);
+		this->frame_pacer.report(out);
+		dprintln("frame stats written to ", this->cfg_params.frame_stats_fname);
+	}
+}
+
+/*
+	Steps the world with a fixed dt as fast as the CPU allows.
+	No window, renderer or event manager is used.
+*/
+
+void Main::run_headless ()
+{
+	const uint64_t n_ticks = this->cfg_params.headless_ticks;
+	const float dt = this->cfg_params.headless_dt;
+
+	this->state = State::playing;
+
+	dprintln("running ", n_ticks, " ticks headless with dt=", dt);
+
+	const ClockTime tbegin = Clock::now();
+
+	for (uint64_t i = 0; i < n_ticks && this->alive; i++)
+		this->world->step(dt, nullptr);
+
+	const double elapsed = ClockDuration_to_double(Clock::now() - tbegin);
+	const double ticks_per_second = static_cast<double>(this->world->get_n_ticks()) / elapsed;
+
+	dprintln("headless run finished: ", this->world->get_n_ticks(), " ticks in ", elapsed, "s",
+		" (", ticks_per_second, " ticks/s, ", ticks_per_second * dt, "x real time), ",
+		this->world->get_n_ghost_contacts(), " pacman-ghost contacts, ",
+		this->world->get_ref_context().timer.get_n_fired(), " timers fired, ", this->world->get_ref_context().timer.get_n_pending(), " pending");
+}
+
+/*
+	Like run_headless, but for many worlds of the same map at once,
+	with consecutive seeds starting at the seed of our world.
+	The worlds, not the ghosts, are spread over the thread pool.
+*/
+
+void Main::run_batch ()
+{
+	const uint32_t n_worlds = this->cfg_params.batch_worlds;
+	const uint64_t n_ticks = this->cfg_params.headless_ticks;
+	const float dt = this->cfg_params.headless_dt;
+
+	this->state = State::playing;
+
+	dprintln("running ", n_worlds, " worlds for ", n_ticks, " ticks headless with dt=", dt);
+
+	const ClockTime tbegin = Clock::now();
+
+	WorldBatch batch(*this->thread_pool, this->world->get_ref_map(), this->world->get_ref_random().get_seed(), n_worlds);
+
+	const ClockTime tcreated = Clock::now();
+
+	batch.run(n_ticks, dt);
+
+	const double elapsed = ClockDuration_to_double(Clock::now() - tcreated);
+	const double ticks_per_second = static_cast<double>(n_ticks * n_worlds) / elapsed;
+
+	uint64_t min_contacts = std::numeric_limits<uint64_t>::max();
+	uint64_t max_contacts = 0;
+	uint64_t total_contacts = 0;
+
+	for (uint32_t i = 0; i < batch.size(); i++) {
+		const uint64_t n_contacts = batch.get_world(i).get_n_ghost_contacts();
+
+		min_contacts = std::min(min_contacts, n_contacts);
+		max_contacts = std::max(max_contacts, n_contacts);
+		total_contacts += n_contacts;
+	}
+
+	dprintln("batch run finished: ", n_worlds, " worlds created in ", ClockDuration_to_double(tcreated - tbegin), "s, ",
+		n_ticks * n_worlds, " ticks in ", elapsed, "s",
+		" (", ticks_per_second, " ticks/s, ", ticks_per_second * dt, "x real time), ",
+		"pacman-ghost contacts per world min/mean/max ", min_contacts, "/", static_cast<double>(total_contacts) / static_cast<double>(n_worlds), "/", max_contacts,
+		", state hash ", batch.get_state_hash());
+}
+
+/*
+	Like run_headless, but renders a frame after each step,
+	to the RecordingRenderer or the SoftwareRenderer.
+	Measures the cost of rendering without a video device.
+*/
+
+void Main::run_offscreen ()
+{
+	const uint64_t n_frames = this->cfg_params.headless_ticks;
+	const float dt = this->cfg_params.headless_dt;
+	const auto *recording_renderer = static_cast<RecordingRenderer*>(this->renderer);
+
+	this->state = State::playing;
+
+	dprintln("rendering ", n_frames, " frames offscreen with dt=", dt);
+
+	const ClockTime tbegin = Clock::now();
+
+	for (uint64_t i = 0; i < n_frames && this->alive; i++) {
+		const ClockTime tframe = Clock::now();
+		ClockTime tphase = tframe;
+
+		auto end_phase = [this, &tphase] (const FrameStats::Phase phase) {
+			const ClockTime t = Clock::now();
+			this->frame_stats.add(phase, t - tphase);
+			tphase = t;
+		};
+
+		this->world->advance_time(dt);
+		end_phase(FrameStats::Phase::TimerTriggers);
+
+		this->world->physics(dt, nullptr);
+		end_phase(FrameStats::Phase::Physics);
+
+		this->world->render(1.0f);
+		end_phase(FrameStats::Phase::WorldRender);
+
+		this->renderer->render();
+		end_phase(FrameStats::Phase::RendererRender);
+
+		this->renderer->update_screen();
+		end_phase(FrameStats::Phase::UpdateScreen);
+
+		this->frame_stats.add(FrameStats::Phase::Frame, tphase - tframe);
+		this->frame_stats.end_frame();
+	}
+
+	const double elapsed = ClockDuration_to_double(Clock::now() - tbegin);
+
+	dprintln("offscreen run finished: ", recording_renderer->get_n_frames(), " frames in ", elapsed, "s",
+		" (", static_cast<double>(recording_renderer->get_n_frames()) / elapsed, " frames/s)");
+
+	recording_renderer->report();
+
+	if (this->cfg_params.frame_stats)
+		this->report_frame_stats();
+}
+
+/*
+	Simulates a recorded session headless, as fast as possible,
+	publishing the recorded moves at the same ticks as in the recording.
+*/
+
+void Main::run_replay ()
+{
+	const std::vector<Replay::Move>& moves = this->replay->get_ref_moves();
+	const uint64_t n_ticks = this->replay->get_n_ticks();
+	const float dt = this->replay->get_dt();
+	size_t next_move = 0;
+
+	this->state = State::playing;
+
+	dprintln("replaying ", moves.size(), " moves in ", n_ticks, " ticks with dt=", dt);
+
+	const ClockTime tbegin = Clock::now();
+
+	while (this->world->get_n_ticks() < n_ticks && this->alive) {
+		while (next_move < moves.size() && moves[next_move].tick == this->world->get_n_ticks()) {
+			this->world->get_ref_context().move.publish( Events::MoveData { .direction = moves[next_move].direction } );
+			next_move++;
+		}
+
+		this->world->step(dt, nullptr);
 	}
+
+	const double elapsed = ClockDuration_to_double(Clock::now() - tbegin);
+	const double ticks_per_second = static_cast<double>(this->world->get_n_ticks()) / elapsed;
+	const uint64_t state_hash = this->world->get_state_hash();
+
+	dprintln("replay finished: ", this->world->get_n_ticks(), " ticks in ", elapsed, "s",
+		" (", ticks_per_second, " ticks/s, ", ticks_per_second * dt, "x real time), ",
+		this->world->get_n_ghost_contacts(), " pacman-ghost contacts");
+
+	mylib_assert_exception_msg(state_hash == this->replay->get_state_hash(), "the replay diverged from the recording, state hash ", state_hash, " expected ", this->replay->get_state_hash())
+
+	dprintln("final state matches the recording");
 }
 
-World::World ()
-	: time_create( Clock::now() )
+World::World (const std::string& map_fname, const uint64_t seed)
+	: World(map_fname.empty() ? Map() : Map(map_fname), seed)
+{
+}
+
+World::World (Map&& map_, const uint64_t seed)
+	: context()
+	, time_create( context.sim_time )
+	, n_ticks(0)
+	, random(seed)
 	, player(this)
+	, ghosts(this)
+	, map( std::move(map_) )
+	, n_ghost_contacts(0)
+	, thread_pool(nullptr)
 {
 	this->w = static_cast<float>( this->map.get_w() );
 	this->h = static_cast<float>( this->map.get_h() );
+	this->zoom = Config::default_zoom;
 
 	this->border_thickness = Config::border_thickness_screen_fraction;
 
 	// avoid vector re-allocations
-	this->objects.reserve(100);
+	this->objects.reserve(1);
 
 	this->add_object(player);
 
@@ -252,30 +847,42 @@ World::World ()
 
 	// create ghosts
 
-	for (uint32_t y=0; y<this->map.get_h(); y++) {
-		for (uint32_t x=0; x<this->map.get_w(); x++) {
-			switch (this->map[y, x]) {
-				case Map::Cell::Ghost_start: {
-					Ghost& ghost = this->ghosts.emplace_back(this);
-					ghost.set_pos(Vector( get_cell_center(x), get_cell_center(y) ));
-					this->add_object(ghost);
-				}
-				break;
+	this->ghosts.reserve( static_cast<uint32_t>(this->map.get_ref_ghost_starts().size()) );
 
-				default:
-				break; // clear warnings
-			}
-		}
-	}
+	for (const Map::TilePos& start : this->map.get_ref_ghost_starts())
+		this->ghosts.add( Vector( get_cell_center(start.x), get_cell_center(start.y) ) );
+
+	this->build_wall_blocks();
+
+	this->flow_field.reset(this->map, this->map.get_pacman_start_x(), this->map.get_pacman_start_y());
+
+	this->entity_grid.reset(this->map.get_w(), this->map.get_h(), this->ghosts.size() + static_cast<uint32_t>(this->objects.size()));
+	this->update_entity_grid();
 
 	this->wall_color = Color(0.0f, 0.0f, 1.0f, 1.0f);
 	
-	this->event_timer_wall_color_d = Events::timer.schedule_event(Events::timer.get_current_time() + float_to_ClockDuration(Config::map_tile_color_change_time), Mylib::Event::make_callback_object<Events::Timer::Event>(*this, &World::change_wall_color));
+	for (Object *obj: this->objects)
+		obj->set_prev_pos( obj->get_value_pos() );
+
+	this->event_timer_wall_color_d = this->context.timer.schedule_event(this->context.timer.get_current_time() + float_to_ClockDuration(Config::map_tile_color_change_time), [this] (Events::Timer::Event& event) { this->change_wall_color(event); });
 }
 
 World::~World ()
 {
-	Events::timer.unschedule_event(this->event_timer_wall_color_d);
+	this->context.timer.unschedule_event(this->event_timer_wall_color_d);
+}
+
+void World::step (const float dt, const Uint8 *keys)
+{
+	this->advance_time(dt);
+	this->physics(dt, keys);
+}
+
+void World::advance_time (const float dt)
+{
+	this->context.sim_time += float_to_ClockDuration(dt);
+
+	this->context.timer.trigger_events();
 }
 
 void World::physics (const float dt, const Uint8 *keys)
@@ -283,75 +890,411 @@ void World::physics (const float dt, const Uint8 *keys)
 //	dprintln( "distance between player and ghost[0]: " << Mylib::Math::distance(this->player.get_pos(), this->ghosts[0].get_pos()) )
 
 	for (Object *obj: this->objects) {
+		obj->set_prev_pos( obj->get_value_pos() );
 		obj->physics(dt, keys);
 	}
 
+	// the player already moved, so the ghosts chase its new tile
+	this->flow_field.update(this->map,
+		static_cast<uint32_t>( this->player.get_x() ),
+		static_cast<uint32_t>( this->player.get_y() ));
+
+	this->ghosts.physics(dt);
+
 	this->solve_wall_collisions();
+	this->publish_wall_collisions();
+
+	this->update_entity_grid();
+
+	this->check_ghost_contacts();
+
+	this->n_ticks++;
 }
 
+/*
+	The object that hit a wall is notified directly, instead of
+	every entity filtering a broadcast of every collision.
+*/
+
 void World::solve_wall_collisions ()
 {
-	for (Object *obj: this->objects) {
+	const uint32_t n_ghosts = this->ghosts.size();
+
+	this->object_wall_hits.clear();
+
+	for (uint32_t j = 0; j < this->objects.size(); j++) {
+		Object *obj = this->objects[j];
 		const Vector cell_center = get_cell_center(obj->get_value_pos());
-		const int32_t xi = static_cast<uint32_t>( obj->get_x() );
-		const int32_t yi = static_cast<uint32_t>( obj->get_y() );
+		const uint32_t xi = static_cast<uint32_t>( obj->get_x() );
+		const uint32_t yi = static_cast<uint32_t>( obj->get_y() );
+		const uint8_t exits = this->map.get_exits(xi, yi);
+
+		auto collide = [this, obj, n_ghosts, j] (const Object::Direction direction) {
+			obj->collided_with_wall(direction);
+			this->object_wall_hits.push_back( Events::WallCollisionData { .entity_id = n_ghosts + j, .direction = direction } );
+			obj->set_direction(Object::Direction::Stopped);
+		};
 
-		if (obj->get_x() < cell_center.x && this->map[yi, xi-1] == Map::Cell::Wall) {
+		if (obj->get_x() < cell_center.x && !(exits & Map::exit_left)) {
 			obj->set_x(cell_center.x);
 			obj->set_vx(0.0f);
-			Events::wall_collision.publish( Events::WallCollisionData { .coll_obj = *obj, .direction = Object::Direction::Left } );
-			obj->set_direction(Object::Direction::Stopped);
+			collide(Object::Direction::Left);
 		}
-		else if (obj->get_x() > cell_center.x && this->map[yi, xi+1] == Map::Cell::Wall) {
+		else if (obj->get_x() > cell_center.x && !(exits & Map::exit_right)) {
 			obj->set_x(cell_center.x);
 			obj->set_vx(0.0f);
-			Events::wall_collision.publish( Events::WallCollisionData { .coll_obj = *obj, .direction = Object::Direction::Right } );
-			obj->set_direction(Object::Direction::Stopped);
+			collide(Object::Direction::Right);
 		}
 
-		if (obj->get_y() < cell_center.y && this->map[yi-1, xi] == Map::Cell::Wall) {
+		if (obj->get_y() < cell_center.y && !(exits & Map::exit_up)) {
 			obj->set_y(cell_center.y);
 			obj->set_vy(0.0f);
-			Events::wall_collision.publish( Events::WallCollisionData { .coll_obj = *obj, .direction = Object::Direction::Up } );
-			obj->set_direction(Object::Direction::Stopped);
+			collide(Object::Direction::Up);
 		}
-		else if (obj->get_y() > cell_center.y && this->map[yi+1, xi] == Map::Cell::Wall) {
+		else if (obj->get_y() > cell_center.y && !(exits & Map::exit_down)) {
 			obj->set_y(cell_center.y);
 			obj->set_vy(0.0f);
-			Events::wall_collision.publish( Events::WallCollisionData { .coll_obj = *obj, .direction = Object::Direction::Down } );
-			obj->set_direction(Object::Direction::Stopped);
+			collide(Object::Direction::Down);
 		}
 	}
 }
 
+/*
+	Ghosts handle their own wall hits inside their physics,
+	so here we only let the observers know about them.
+*/
+
+void World::publish_wall_collisions ()
+{
+	for (const Ghosts::WallHit& hit : this->ghosts.get_ref_wall_hits())
+		this->context.wall_collision.publish( Events::WallCollisionData { .entity_id = hit.ghost_id, .direction = hit.direction } );
+
+	for (const Events::WallCollisionData& hit : this->object_wall_hits)
+		this->context.wall_collision.publish(hit);
+}
+
 void World::change_wall_color (Events::Timer::Event& event)
 {
 	//dprintln("Changing wall color")
 
-	std::uniform_real_distribution<float> d (0.0f, 1.0f);
-	auto& r = probability.get_ref_rgenerator();
+	const Random::Numbers r = this->random.get(Random::Stream::WallColor, 0, this->n_ticks);
 
-	this->wall_color = Color(d(r), d(r), d(r), 1.0f);
+	this->wall_color = Color(Random::to_float(r[0]), Random::to_float(r[1]), Random::to_float(r[2]), 1.0f);
 
 	event.re_schedule = true;
-	event.time = Events::timer.get_current_time() + float_to_ClockDuration(Config::map_tile_color_change_time);
+	event.time = this->context.timer.get_current_time() + float_to_ClockDuration(Config::map_tile_color_change_time);
 }
 
-void World::render_map ()
+/*
+	Walls are merged per chunk of Config::map_wall_chunk_size tiles,
+	so that we can skip the chunks that are outside of the camera.
+*/
+
+void World::build_wall_blocks ()
 {
-	Rect2D rect(Config::map_tile_size, Config::map_tile_size);
-	const uint32_t n_rects = this->map.get_n_walls();
-	Vector offset;
+	constexpr uint32_t chunk_size = Config::map_wall_chunk_size;
 
-	for (uint32_t y=0; y<this->map.get_h(); y++) {
-		for (uint32_t x=0; x<this->map.get_w(); x++) {
-			switch (this->map[y, x]) {
-				case Map::Cell::Wall:
-					offset.set(static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
-					renderer->draw_rect2D(rect, offset, this->wall_color);
-				break;
+	this->n_wall_chunks_x = (this->map.get_w() + chunk_size - 1) / chunk_size;
+	this->n_wall_chunks_y = (this->map.get_h() + chunk_size - 1) / chunk_size;
+
+	this->wall_blocks.clear();
+	this->wall_chunk_offsets.clear();
+	this->wall_chunk_offsets.reserve(this->n_wall_chunks_x * this->n_wall_chunks_y + 1);
+
+	for (uint32_t cy=0; cy<this->n_wall_chunks_y; cy++) {
+		for (uint32_t cx=0; cx<this->n_wall_chunks_x; cx++) {
+			this->wall_chunk_offsets.push_back( static_cast<uint32_t>(this->wall_blocks.size()) );
+
+			this->merge_wall_blocks( Map::TileRect {
+				.x_begin = cx * chunk_size,
+				.y_begin = cy * chunk_size,
+				.x_end = std::min((cx + 1) * chunk_size, this->map.get_w()),
+				.y_end = std::min((cy + 1) * chunk_size, this->map.get_h())
+				} );
+		}
+	}
+
+	this->wall_chunk_offsets.push_back( static_cast<uint32_t>(this->wall_blocks.size()) );
+
+	dprintln("merged ", this->map.get_n_walls(), " wall tiles into ", this->wall_blocks.size(), " rectangles");
+}
+
+/*
+	Each row is split in horizontal runs of walls.
+	A run that has exactly the same columns as an open rectangle
+	of the previous row extends that rectangle downwards.
+	Otherwise, the rectangle of the previous row is closed.
+*/
+
+void World::merge_wall_blocks (const Map::TileRect& region)
+{
+	struct Run {
+		uint32_t x_begin;
+		uint32_t x_end; // not included
+		uint32_t y_begin;
+	};
+
+	std::vector<Run> open, row_runs;
+
+	auto close_run = [this] (const Run& run, const uint32_t y_end) {
+		const float w = static_cast<float>(run.x_end - run.x_begin) * Config::map_tile_size;
+		const float h = static_cast<float>(y_end - run.y_begin) * Config::map_tile_size;
+
+		this->wall_blocks.push_back( WallBlock {
+			.rect = Rect2D(w, h),
+			.pos = Vector(static_cast<float>(run.x_begin) * Config::map_tile_size + w*0.5f, static_cast<float>(run.y_begin) * Config::map_tile_size + h*0.5f)
+			} );
+	};
+
+	for (uint32_t y=region.y_begin; y<region.y_end; y++) {
+		row_runs.clear();
+
+		for (uint32_t x=region.x_begin; x<region.x_end; ) {
+			if (this->map[y, x] != Map::Cell::Wall) {
+				x++;
+				continue;
+			}
+
+			const uint32_t x_begin = x;
+
+			while (x < region.x_end && this->map[y, x] == Map::Cell::Wall)
+				x++;
+
+			row_runs.push_back( Run { .x_begin = x_begin, .x_end = x, .y_begin = y } );
+		}
+
+		// both lists are sorted by x_begin
+
+		uint32_t i = 0;
+
+		for (Run& run : row_runs) {
+			while (i < open.size() && open[i].x_begin < run.x_begin)
+				close_run(open[i++], y);
+
+			if (i < open.size() && open[i].x_begin == run.x_begin) {
+				if (open[i].x_end == run.x_end)
+					run.y_begin = open[i].y_begin;
+				else
+					close_run(open[i], y);
+
+				i++;
+			}
+		}
+
+		while (i < open.size())
+			close_run(open[i++], y);
+
+		std::swap(open, row_runs);
+	}
+
+	for (const Run& run : open)
+		close_run(run, region.y_end);
+}
+
+void World::update_entity_grid ()
+{
+	const uint32_t n_ghosts = this->ghosts.size();
+
+	for (uint32_t i = 0; i < n_ghosts; i++)
+		this->entity_grid.update(i, this->ghosts.get_pos(i));
+
+	for (uint32_t i = 0; i < this->objects.size(); i++)
+		this->entity_grid.update(n_ghosts + i, this->objects[i]->get_value_pos());
+}
+
+uint64_t World::get_state_hash () const
+{
+	uint64_t hash = 0xCBF29CE484222325;
+
+	auto add = [&hash] (const auto v) {
+		const auto bits = std::bit_cast< std::conditional_t<sizeof(v) == 8, uint64_t, uint32_t> >(v);
+		hash = (hash ^ static_cast<uint64_t>(bits)) * 0x100000001B3;
+	};
+
+	add(this->n_ticks);
+	add(this->n_ghost_contacts);
+
+	for (const Object *obj : this->objects) {
+		add(obj->get_x());
+		add(obj->get_y());
+		add(obj->get_vx());
+		add(obj->get_vy());
+		add( static_cast<uint32_t>( std::to_underlying(obj->get_direction()) ) );
+	}
+
+	for (uint32_t i = 0; i < this->ghosts.size(); i++) {
+		add(this->ghosts.get_ref_x()[i]);
+		add(this->ghosts.get_ref_y()[i]);
+		add(this->ghosts.get_ref_vx()[i]);
+		add(this->ghosts.get_ref_vy()[i]);
+		add( static_cast<uint32_t>( std::to_underlying(this->ghosts.get_ref_direction()[i]) ) );
+	}
+
+	return hash;
+}
+
+uint32_t World::find_nearest_ghost (const Vector& pos) const
+{
+	const uint32_t n_ghosts = this->ghosts.size();
+
+	if (n_ghosts == 0)
+		return SpatialGrid::none;
+
+	return this->entity_grid.find_nearest(pos,
+		[this] (const uint32_t id) { return this->get_entity_pos(id); },
+		[n_ghosts] (const uint32_t id) { return id < n_ghosts; }
+		);
+}
+
+// publishes Events::ghost_contact in every step in which pacman overlaps a ghost
+
+void World::save_state (std::vector<uint8_t>& state) const
+{
+	static_assert(std::is_trivially_copyable_v<StateHeader>);
+
+	const ClockTime now = this->context.sim_time;
+	StateHeader header;
+
+	// the header has padding, which must be zero so that equal states give equal buffers
+	std::memset(static_cast<void*>(&header), 0, sizeof(StateHeader));
+
+	header.seed = this->random.get_seed();
+	header.n_ticks = this->n_ticks;
+	header.n_ghost_contacts = this->n_ghost_contacts;
+	header.time = now - this->time_create;
+	header.wall_color_time_left = this->context.timer.get_event_time(this->event_timer_wall_color_d) - now;
+	header.ghost_color_time_left = this->ghosts.get_color_change_time() - now;
+	header.wall_color = this->wall_color;
+	header.player_pos = this->player.get_value_pos();
+	header.player_prev_pos = this->player.get_value_prev_pos();
+	header.player_vel = this->player.get_value_vel();
+	header.player_color = this->player.get_value_color();
+	header.player_direction = this->player.get_direction();
+	header.player_target_direction = this->player.get_target_direction();
+	this->flow_field.get_state(header.flow_field);
+	header.n_ghosts = this->ghosts.size();
+
+	state.resize(sizeof(StateHeader) + this->ghosts.get_state_size());
+
+	std::memcpy(state.data(), &header, sizeof(StateHeader));
+	this->ghosts.save_state(state.data() + sizeof(StateHeader));
+}
+
+void World::restore_state (const std::vector<uint8_t>& state, const std::optional<uint64_t> new_seed)
+{
+	StateHeader header;
+
+	mylib_assert_exception_msg(state.size() >= sizeof(StateHeader), "invalid world state, ", state.size(), " bytes")
+
+	std::memcpy(&header, state.data(), sizeof(StateHeader));
+
+	mylib_assert_exception_msg((new_seed.has_value() || header.seed == this->random.get_seed()) && header.n_ghosts == this->ghosts.size()
+		&& state.size() == (sizeof(StateHeader) + this->ghosts.get_state_size()),
+		"the world state belongs to another world, seed ", header.seed, ", ", header.n_ghosts, " ghosts")
+
+	// the random numbers are keyed by the seed, so this is all it takes to change it
+	if (new_seed.has_value())
+		this->random = Random(*new_seed);
+
+	this->n_ticks = header.n_ticks;
+	this->n_ghost_contacts = header.n_ghost_contacts;
+	this->wall_color = header.wall_color;
+
+	this->player.set_pos(header.player_pos);
+	this->player.set_prev_pos(header.player_prev_pos);
+	this->player.set_vel(header.player_vel);
+	this->player.set_color(header.player_color);
+	this->player.set_direction(header.player_direction);
+	this->player.set_target_direction(header.player_target_direction);
+
+	this->ghosts.restore_state(state.data() + sizeof(StateHeader));
+
+	this->flow_field.restore_state(this->map, header.flow_field);
+
+	// the clock may jump back, so the timers are filed again
+	this->context.sim_time = this->time_create + header.time;
+	this->context.timer.resync();
+
+	this->context.timer.unschedule_event(this->event_timer_wall_color_d);
+	this->event_timer_wall_color_d = this->context.timer.schedule_event(this->context.sim_time + header.wall_color_time_left, [this] (Events::Timer::Event& event) { this->change_wall_color(event); });
+
+	this->ghosts.set_color_change_time(this->context.sim_time + header.ghost_color_time_left);
+
+	this->object_wall_hits.clear();
+	this->update_entity_grid();
+}
+
+void World::check_ghost_contacts ()
+{
+	const uint32_t n_ghosts = this->ghosts.size();
+	constexpr float contact_distance = Config::pacman_radius + Config::ghost_radius;
+
+	this->entity_grid.for_each_in_radius(this->player.get_value_pos(), contact_distance,
+		[this] (const uint32_t id) { return this->get_entity_pos(id); },
+		[this, n_ghosts] (const uint32_t id, const float distance_sq) {
+			if (id >= n_ghosts)
+				return;
+
+			this->n_ghost_contacts++;
+			this->context.ghost_contact.publish( Events::GhostContactData { .pacman = this->player, .ghost_id = id } );
+		});
+}
+
+/*
+	Computes the same camera window as the renderer, including
+	force_camera_inside_world, and converts it to tiles.
+*/
+
+Map::TileRect World::get_visible_tiles (const Vector& camera_focus) const
+{
+	// objects and the render interpolation may stick out of their tiles
+	constexpr float margin = 1.0f;
 
-				default: break; // clear warnings
+	const Vector ws = this->context.renderer->get_normalized_window_size();
+	const float view_w = this->w / this->zoom;
+	const float view_h = view_w * (ws.y / ws.x);
+
+	auto visible_range = [margin] (const float focus, const float view_size, const float world_size, uint32_t& begin, uint32_t& end) {
+		const uint32_t n_tiles = static_cast<uint32_t>(world_size);
+
+		if (view_size >= world_size) {
+			begin = 0;
+			end = n_tiles;
+			return;
+		}
+
+		const float center = std::clamp(focus, view_size * 0.5f, world_size - view_size * 0.5f);
+		const float first = std::floor(center - view_size * 0.5f - margin);
+		const float last = std::ceil(center + view_size * 0.5f + margin);
+
+		begin = static_cast<uint32_t>( std::max(first, 0.0f) );
+		end = std::min(static_cast<uint32_t>( std::max(last, 0.0f) ), n_tiles);
+	};
+
+	Map::TileRect visible;
+
+	visible_range(camera_focus.x, view_w, this->w, visible.x_begin, visible.x_end);
+	visible_range(camera_focus.y, view_h, this->h, visible.y_begin, visible.y_end);
+
+	return visible;
+}
+
+void World::render_map (const Map::TileRect& visible, const Color& color)
+{
+	constexpr uint32_t chunk_size = Config::map_wall_chunk_size;
+
+	const uint32_t cx_begin = visible.x_begin / chunk_size;
+	const uint32_t cy_begin = visible.y_begin / chunk_size;
+	const uint32_t cx_end = std::min((visible.x_end + chunk_size - 1) / chunk_size, this->n_wall_chunks_x);
+	const uint32_t cy_end = std::min((visible.y_end + chunk_size - 1) / chunk_size, this->n_wall_chunks_y);
+
+	for (uint32_t cy=cy_begin; cy<cy_end; cy++) {
+		for (uint32_t cx=cx_begin; cx<cx_end; cx++) {
+			const uint32_t chunk = cy * this->n_wall_chunks_x + cx;
+
+			for (uint32_t i = this->wall_chunk_offsets[chunk]; i < this->wall_chunk_offsets[chunk + 1]; i++) {
+				const WallBlock& block = this->wall_blocks[i];
+				this->context.renderer->draw_rect2D(block.rect, block.pos, color);
 			}
 		}
 	}
@@ -363,40 +1306,47 @@ void World::render_box()
 	Vector offset;
 	float w, h;
 	const auto color = Color(0.0f, 1.0f, 0.0f, 1.0f);
-	const Vector ws = renderer->get_normalized_window_size();
+	const Vector ws = this->context.renderer->get_normalized_window_size();
 	
 	w = this->border_thickness;
 	h = ws.y;
 	offset.set(w*0.5f, ws.y*0.5f);
 	rect = Rect2D(w, h);
-	renderer->draw_rect2D(rect, offset, color);
+	this->context.renderer->draw_rect2D(rect, offset, color);
 
 	offset.set(ws.x - w*0.5f, ws.y*0.5f);
-	renderer->draw_rect2D(rect, offset, color);
+	this->context.renderer->draw_rect2D(rect, offset, color);
 
 	w = ws.x;
 	h = this->border_thickness;
 	offset.set(ws.x*0.5f, h*0.5f);
 	rect = Rect2D(w, h);
-	renderer->draw_rect2D(rect, offset, color);
+	this->context.renderer->draw_rect2D(rect, offset, color);
 
 	offset.set(ws.x*0.5f, ws.y - h*0.5f);
-	renderer->draw_rect2D(rect, offset, color);
+	this->context.renderer->draw_rect2D(rect, offset, color);
 }
 
-void World::render (const float dt)
+void World::setup_render (const Vector& camera_focus)
 {
-	const Vector ws = renderer->get_normalized_window_size();
+	const Vector ws = this->context.renderer->get_normalized_window_size();
 
-	renderer->setup_render_2D( {
+	this->context.renderer->setup_render_2D( {
 		.clip_init_norm = Vector(0.0f, 0.0f),
 		.clip_end_norm = Vector(ws.x, ws.y),
 		.world_init = Vector(0.0f, 0.0f),
 		.world_end = Vector(this->w, this->h),
 		.force_camera_inside_world = true,
-		.world_camera_focus = player.get_value_pos(),
-		.world_screen_width = this->w * (1.0f / Main::get()->get_cfg_params().zoom)
+		.world_camera_focus = camera_focus,
+		.world_screen_width = this->w * (1.0f / this->zoom)
 		} );
+}
+
+void World::render (const float alpha)
+{
+	const Vector camera_focus = player.get_render_pos(alpha);
+
+	this->setup_render(camera_focus);
 
 /*	renderer->setup_projection_matrix( Graphics::ProjectionMatrixArgs {
 		.clip_init_norm = Vector(this->border_thickness, this->border_thickness),
@@ -405,7 +1355,7 @@ void World::render (const float dt)
 		.world_end = Vector(this->w, this->h),
 		.force_camera_inside_world = true,
 		.world_camera_focus = player.get_value_pos(),
-		.world_screen_width = this->w * (1.0f / Main::get()->get_cfg_params().zoom)
+		.world_screen_width = this->w * (1.0f / this->zoom)
 		} );*/
 	
 	/*renderer->setup_projection_matrix( Graphics::ProjectionMatrixArgs {
@@ -415,14 +1365,25 @@ void World::render (const float dt)
 		.world_end = Vector(this->w, this->h),
 		.force_camera_inside_world = true,
 		.world_camera_focus = player.get_pos(),
-		.world_screen_width = this->w * (1.0f / Main::get()->get_cfg_params().zoom)
+		.world_screen_width = this->w * (1.0f / this->zoom)
 		} );*/
 
-	this->render_map();
+	const Map::TileRect visible = this->get_visible_tiles(camera_focus);
 
-	for (Object *obj: this->objects) {
-		obj->render(dt);
-	}
+	this->render_map(visible, this->wall_color);
+
+	const uint32_t n_ghosts = this->ghosts.size();
+
+	this->circle_instances.clear();
+
+	this->entity_grid.for_each_in_tiles(visible.x_begin, visible.y_begin, visible.x_end, visible.y_end, [this, alpha, n_ghosts] (const uint32_t id) {
+		if (id < n_ghosts)
+			this->ghosts.render(id, alpha, this->circle_instances);
+		else
+			this->objects[id - n_ghosts]->render(alpha, this->circle_instances);
+	});
+
+	this->context.renderer->draw_circles2D(this->circle_instances);
 
 #if 0
 	renderer->setup_projection_matrix( Graphics::ProjectionMatrixArgs {
@@ -438,6 +1399,58 @@ void World::render (const float dt)
 #endif
 }
 
+void World::fill_snapshot (Snapshot& snapshot)
+{
+	const uint32_t n_ghosts = this->ghosts.size();
+
+	snapshot.n_ticks = this->n_ticks;
+	snapshot.camera_prev = this->player.get_render_pos(0.0f);
+	snapshot.camera = this->player.get_render_pos(1.0f);
+	snapshot.wall_color = this->wall_color;
+
+	snapshot.prev_circles.clear();
+	snapshot.circles.clear();
+
+	for (uint32_t i = 0; i < n_ghosts; i++) {
+		this->ghosts.render(i, 0.0f, snapshot.prev_circles);
+		this->ghosts.render(i, 1.0f, snapshot.circles);
+	}
+
+	for (Object *obj : this->objects) {
+		obj->render(0.0f, snapshot.prev_circles);
+		obj->render(1.0f, snapshot.circles);
+	}
+}
+
+void World::render_snapshot (const Snapshot& snapshot, const float alpha)
+{
+	const Vector camera_focus = snapshot.camera_prev + (snapshot.camera - snapshot.camera_prev) * alpha;
+
+	this->setup_render(camera_focus);
+
+	const Map::TileRect visible = this->get_visible_tiles(camera_focus);
+
+	this->render_map(visible, snapshot.wall_color);
+
+	const float x_begin = static_cast<float>(visible.x_begin);
+	const float y_begin = static_cast<float>(visible.y_begin);
+	const float x_end = static_cast<float>(visible.x_end);
+	const float y_end = static_cast<float>(visible.y_end);
+
+	this->circle_instances.clear();
+
+	for (size_t i = 0; i < snapshot.circles.size(); i++) {
+		const CircleInstance& prev = snapshot.prev_circles[i];
+		const CircleInstance& circle = snapshot.circles[i];
+		const Vector pos = prev.pos + (circle.pos - prev.pos) * alpha;
+
+		if (pos.x >= x_begin && pos.x < x_end && pos.y >= y_begin && pos.y < y_end)
+			this->circle_instances.push_back( CircleInstance { .pos = pos, .radius = circle.radius, .color = circle.color } );
+	}
+
+	this->context.renderer->draw_circles2D(this->circle_instances);
+}
+
 // ---------------------------------------------------
 
 } // end namespace Game
\ No newline at end of file
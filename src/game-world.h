@@ -10,6 +10,7 @@
 #include <vector>
 #include <list>
 #include <string>
+#include <optional>
 #include <type_traits>
 
 #include <my-lib/std.h>
@@ -20,31 +21,59 @@
 #include "game-object.h"
 #include "lib.h"
 #include "events.h"
+#include "frame-stats.h"
+#include "frame-pacer.h"
+#include "spatial-grid.h"
+#include "thread-pool.h"
+#include "flow-field.h"
+#include "replay.h"
+#include "software-renderer.h"
+#include "world-context.h"
 
 namespace Game
 {
 
 // ---------------------------------------------------
 
-inline MyGlib::Graphics::Manager *renderer = nullptr;
-inline MyGlib::Event::Manager *event_manager = nullptr;
-inline Probability probability;
-
-// ---------------------------------------------------
-
 class World;
+class SimulationThread;
 
 // ---------------------------------------------------
 
 class Main
 {
 public:
+	enum class OffscreenVideo {
+		None,
+		Null, // the rendering commands are only recorded
+		Software // rasterized in memory by the SoftwareRenderer
+	};
+
 	struct InitConfig {
 		MyGlib::Graphics::Manager::Type graphics_type;
 		uint32_t window_width_px;
 		uint32_t window_height_px;
+		float target_fps;
+		FramePacer::Mode frame_pacing;
 		bool fullscreen;
 		float zoom;
+		std::string map_fname; // if empty, the built-in map is used
+		bool headless; // no window, no graphics, simulation only
+		OffscreenVideo offscreen_video; // if not None, there is no window
+		std::string frame_dump_dir; // software video only, if not empty the frames are saved here
+		uint32_t frame_dump_interval; // in frames
+		uint64_t headless_ticks;
+		float headless_dt;
+		uint32_t batch_worlds; // headless only, if not 0 this many worlds are simulated side by side
+		bool frame_stats; // report the frame stats and the input latency at exit
+		bool late_input; // process the input right before the physics, instead of at the start of the frame
+		bool threaded_sim; // simulate in its own thread, overlapped with the rendering
+		FrameStats::Format frame_stats_format;
+		std::string frame_stats_fname; // if empty, report to the debug output
+		uint32_t n_threads; // 0 means one per hardware thread
+		std::optional<uint64_t> seed; // if not set, a random seed is used
+		std::string record_fname; // if not empty, the input is recorded to this replay file
+		std::string replay_fname; // if not empty, this replay is simulated headless
 	};
 
 	enum class State {
@@ -56,7 +85,21 @@ protected:
 	MYLIB_OO_ENCAPSULATE_PTR(World*, world)
 	MYLIB_OO_ENCAPSULATE_SCALAR(bool, alive)
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(State, state)
-	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(InitConfig, cfg_params)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(InitConfig, cfg_params)
+	MYLIB_OO_ENCAPSULATE_OBJ(FrameStats, frame_stats)
+	MYLIB_OO_ENCAPSULATE_OBJ(InputLatency, input_latency)
+	MYLIB_OO_ENCAPSULATE_OBJ(FramePacer, frame_pacer)
+	MYLIB_OO_ENCAPSULATE_PTR(ThreadPool*, thread_pool)
+
+	// owned by Main, and given to the context of the world; null when headless
+	MYLIB_OO_ENCAPSULATE_PTR(Renderer*, renderer)
+	MYLIB_OO_ENCAPSULATE_PTR(MyGlib::Event::Manager*, event_manager)
+
+	// only while run simulates in its own thread
+	MYLIB_OO_ENCAPSULATE_PTR(SimulationThread*, sim_thread)
+
+	Replay *replay;
+	ReplayRecorder *recorder;
 
 	MyGlib::Event::Quit::Descriptor event_quit_d;
 	MyGlib::Lib *lib;
@@ -70,7 +113,12 @@ protected:
 public:
 	void load (const InitConfig& cfg);
 	void run ();
+	void run_headless ();
+	void run_batch ();
+	void run_offscreen ();
+	void run_replay ();
 	void cleanup ();
+	void report_frame_stats ();
 	void event_quit (const MyGlib::Event::Quit::Type);
 
 	static inline Main* get ()
@@ -84,16 +132,58 @@ public:
 
 // ---------------------------------------------------
 
+/*
+	Maps can be loaded from two file formats:
+
+	- Text: one line per row, all rows with the same width.
+	  '0' is a wall, 'p' the pacman start, 'g' a ghost start and ' ' an empty cell.
+
+	- Binary: the magic "PMAP", followed by the version, width and height
+	  as little-endian uint32_t, followed by the cells in row-major order,
+	  2 bits per cell (the value of Map::Cell), 4 cells per byte.
+*/
+
 class Map
 {
 public:
-	enum class Cell {
+	enum class Cell : uint8_t {
 		Empty,
 		Wall,
 		Pacman_start,
 		Ghost_start
 	};
 
+	struct TilePos {
+		uint32_t x;
+		uint32_t y;
+	};
+
+	// tiles in [x_begin, x_end) x [y_begin, y_end)
+	struct TileRect {
+		uint32_t x_begin;
+		uint32_t y_begin;
+		uint32_t x_end;
+		uint32_t y_end;
+	};
+
+	/*
+		Bits of the exits table.
+		Bit d is set if the neighbour of the cell in direction d is not a wall.
+		The junction bit is set when a cell is not a straight corridor,
+		i.e., when it is possible to change direction in it.
+		Nothing reads it yet: it is reserved for AI that only decides
+		at junctions, which would change the ghosts' behaviour.
+	*/
+	static constexpr uint8_t exit_left = 1 << std::to_underlying(Events::MoveData::Direction::Left);
+	static constexpr uint8_t exit_right = 1 << std::to_underlying(Events::MoveData::Direction::Right);
+	static constexpr uint8_t exit_up = 1 << std::to_underlying(Events::MoveData::Direction::Up);
+	static constexpr uint8_t exit_down = 1 << std::to_underlying(Events::MoveData::Direction::Down);
+	static constexpr uint8_t junction = 1 << 4;
+
+	static constexpr char binary_magic[4] = { 'P', 'M', 'A', 'P' };
+	static constexpr uint32_t binary_version = 1;
+	static constexpr uint32_t binary_header_size = 16;
+
 protected:
 	Mylib::Matrix<Cell> map;
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, w)
@@ -101,11 +191,72 @@ protected:
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, n_walls)
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, pacman_start_x)
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, pacman_start_y)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<TilePos>, ghost_starts)
+
+	// per cell, in row-major order
+	std::vector<uint8_t> exits;
 
 public:
+	// loads the built-in map
 	Map ();
+
+	// loads a map file, either text or binary
+	Map (const std::string& fname);
+
+	/*
+		Generates a w x h map, for benchmarks and tests:
+		walls on the border and on every cell with even x and y,
+		pacman on (1, 1), and the ghosts spread over the free cells.
+		If there are more ghosts than free cells, some cells start more than one ghost.
+	*/
+	Map (const uint32_t w_, const uint32_t h_, const uint32_t n_ghosts);
+
+	Map (const Map& other) = default;
+	Map (Map&& other) = default;
+
 	~Map ();
 
+	void save_binary (const std::string& fname) const;
+
+	// identifies the map in replay files
+	uint64_t get_hash () const;
+
+	inline uint8_t get_exits (const uint32_t x, const uint32_t y) const
+	{
+		return this->exits[y * this->w + x];
+	}
+
+protected:
+	void parse_text (const char *data, const size_t size);
+	void parse_binary (const char *data, const size_t size);
+	void allocate (const uint32_t w_, const uint32_t h_);
+	void finish_loading ();
+	void build_exits ();
+
+	inline void set_cell (const uint32_t x, const uint32_t y, const Cell cell)
+	{
+		this->map[y, x] = cell;
+
+		switch (cell) {
+			case Cell::Wall:
+				this->n_walls++;
+			break;
+
+			case Cell::Pacman_start:
+				this->pacman_start_x = x;
+				this->pacman_start_y = y;
+			break;
+
+			case Cell::Ghost_start:
+				this->ghost_starts.push_back( TilePos { .x = x, .y = y } );
+			break;
+
+			default: break; // clear warnings
+		}
+	}
+
+public:
+
 	inline Cell get (const int row, const int col) const
 	{
 		return this->map[row, col];
@@ -126,29 +277,125 @@ public:
 
 class World
 {
+public:
+	// a rectangle of wall tiles, with its center position
+	struct WallBlock {
+		Rect2D rect;
+		Vector pos;
+	};
+
+	/*
+		Everything needed to render the world after a tick, so that
+		another thread can render it while the next ticks are simulated.
+		prev_circles[i] and circles[i] are the same ghost or object,
+		before and after the tick, for the render interpolation.
+	*/
+	struct Snapshot {
+		uint64_t n_ticks;
+		ClockTime time; // of the end of the tick, in real time
+		uint64_t n_inputs; // number of inputs simulated up to this tick
+		Vector camera_prev;
+		Vector camera;
+		Color wall_color;
+		std::vector<CircleInstance> prev_circles;
+		std::vector<CircleInstance> circles;
+	};
+
+	/*
+		All the gameplay state of a world, to roll it back, restart it
+		or compare two runs: a StateHeader followed by the arrays of the
+		ghosts, see Ghosts::save_state.
+		The random numbers are keyed by the tick, so they need no state.
+		Timers are stored as the time left, relative to the simulation time.
+		The map, the walls and the entity grid are not stored, they never
+		change or are rebuilt from the positions.
+		The player is the only object.
+	*/
+	struct StateHeader {
+		uint64_t seed;
+		uint64_t n_ticks;
+		uint64_t n_ghost_contacts;
+		ClockDuration time; // since the creation of the world
+		ClockDuration wall_color_time_left;
+		ClockDuration ghost_color_time_left;
+		Color wall_color;
+		Vector player_pos;
+		Vector player_prev_pos;
+		Vector player_vel;
+		Color player_color;
+		Object::Direction player_direction;
+		Object::Direction player_target_direction;
+		FlowField::State flow_field;
+		uint32_t n_ghosts;
+	};
+
 protected:
+	// must be the first member, the others use it from their constructors on
+	WorldContext context;
+
 	// width and height of screen
 	// the screen coordinates here are in game world coords (not opengl, neither pixels)
 	// every unit corresponds to a tile
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(float, w)
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(float, h)
 	MYLIB_OO_ENCAPSULATE_SCALAR(ClockTime, time_create) // time instant of world creation
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_ticks) // number of simulation steps
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(Random, random)
 	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(float, border_thickness)
+	MYLIB_OO_ENCAPSULATE_SCALAR(float, zoom)
 
 	MYLIB_OO_ENCAPSULATE_OBJ(Player, player)
-	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::list<Ghost>, ghosts)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(Ghosts, ghosts)
 	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(Map, map)
 
+	// shortest paths to the player, shared by all ghosts
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(FlowField, flow_field)
+
 	Color wall_color;
 	Events::Timer::Descriptor event_timer_wall_color_d;
 
+	// walls never move, so they are merged once into as few rectangles as possible
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<WallBlock>, wall_blocks)
+
+	// the blocks of chunk i are wall_blocks[ wall_chunk_offsets[i] .. wall_chunk_offsets[i+1] )
+	std::vector<uint32_t> wall_chunk_offsets;
+	uint32_t n_wall_chunks_x;
+	uint32_t n_wall_chunks_y;
+
+	// ghost i has entity id i, and objects[j] has entity id (n_ghosts + j)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(SpatialGrid, entity_grid)
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_ghost_contacts)
+
+	// wall hits of the objects in the last tick
+	std::vector<Events::WallCollisionData> object_wall_hits;
+
+	// the visible ghosts and objects, drawn in a single batch; reused across frames
+	std::vector<CircleInstance> circle_instances;
+
+	// if not set, the ghosts are simulated in the calling thread
+	MYLIB_OO_ENCAPSULATE_PTR(ThreadPool*, thread_pool)
+
 protected:
 	std::vector< Object* > objects;
 
 public:
-	World ();
+	World (Map&& map_, const uint64_t seed);
+
+	// if map_fname is empty, the built-in map is used
+	World (const std::string& map_fname, const uint64_t seed);
 	~World ();
 
+	inline WorldContext& get_ref_context ()
+	{
+		return this->context;
+	}
+
+	inline const WorldContext& get_ref_context () const
+	{
+		return this->context;
+	}
+
 	inline void add_object (Object *obj)
 	{
 		this->objects.push_back(obj);
@@ -159,12 +406,61 @@ public:
 		this->objects.push_back(&obj);
 	}
 
+	void step (const float dt, const Uint8 *keys);
+	void advance_time (const float dt);
 	void physics (const float dt, const Uint8 *keys);
 	void solve_wall_collisions ();
+	void publish_wall_collisions ();
+
+	// see Ghosts::move_and_collide
+	inline void move_and_collide_ghosts (const float dt)
+	{
+		this->ghosts.move_and_collide(dt);
+	}
+
 	void change_wall_color (Events::Timer::Event& event);
-	void render_map ();
+	void build_wall_blocks ();
+	void merge_wall_blocks (const Map::TileRect& region);
+	void update_entity_grid ();
+	void check_ghost_contacts ();
+
+	inline Vector get_entity_pos (const uint32_t id) const
+	{
+		const uint32_t n_ghosts = this->ghosts.size();
+
+		return (id < n_ghosts) ? this->ghosts.get_pos(id) : this->objects[id - n_ghosts]->get_value_pos();
+	}
+
+	// hash of the positions and velocities of everything that moves, to check that replays match
+	uint64_t get_state_hash () const;
+
+	/*
+		The buffer is overwritten, and its capacity reused.
+		Neither can be called while a SimulationThread runs the world.
+	*/
+	void save_state (std::vector<uint8_t>& state) const;
+
+	/*
+		The state must come from a world of the same map and seed.
+		If new_seed is given, the state may come from any seed, and
+		the world goes on as a new game with new_seed, e.g. to start
+		over from the initial state without creating the world again.
+	*/
+	void restore_state (const std::vector<uint8_t>& state, const std::optional<uint64_t> new_seed = std::nullopt);
+
+	// returns SpatialGrid::none if there are no ghosts
+	uint32_t find_nearest_ghost (const Vector& pos) const;
+	Map::TileRect get_visible_tiles (const Vector& camera_focus) const;
+	void setup_render (const Vector& camera_focus);
+	void render_map (const Map::TileRect& visible, const Color& color);
 	void render_box();
-	void render (const float dt);
+	void render (const float alpha);
+
+	// the time and inputs of the snapshot are not filled here
+	void fill_snapshot (Snapshot& snapshot);
+
+	// only reads the map, which never changes, so it is safe while another thread simulates
+	void render_snapshot (const Snapshot& snapshot, const float alpha);
 };
 
 // ---------------------------------------------------
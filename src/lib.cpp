@@ -1,4 +1,17 @@
 #include <iostream>
+#include <random>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 #include "lib.h"
 
 namespace Game
@@ -6,13 +19,91 @@ namespace Game
 
 // ---------------------------------------------------
 
-Probability::Probability ()
+uint64_t Random::make_seed ()
 {
 	std::random_device rd;
 
-	this->rgenerator.seed( rd() );
+	return (static_cast<uint64_t>( rd() ) << 32) | static_cast<uint64_t>( rd() );
 }
 
 // ---------------------------------------------------
 
+#ifdef _WIN32
+
+MappedFile::MappedFile (const std::string& fname)
+{
+	this->file_handle = CreateFileA(fname.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	mylib_assert_exception_msg(this->file_handle != INVALID_HANDLE_VALUE, "cannot open file ", fname)
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(this->file_handle, &size) || size.QuadPart == 0) {
+		CloseHandle(this->file_handle);
+		mylib_throw_exception_msg("cannot map empty file ", fname);
+	}
+
+	this->size = static_cast<size_t>(size.QuadPart);
+
+	this->mapping_handle = CreateFileMappingA(this->file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (this->mapping_handle == nullptr) {
+		CloseHandle(this->file_handle);
+		mylib_throw_exception_msg("cannot map file ", fname);
+	}
+
+	this->data = static_cast<const char*>( MapViewOfFile(this->mapping_handle, FILE_MAP_READ, 0, 0, 0) );
+
+	if (this->data == nullptr) {
+		CloseHandle(this->mapping_handle);
+		CloseHandle(this->file_handle);
+		mylib_throw_exception_msg("cannot map file ", fname);
+	}
+}
+
+MappedFile::~MappedFile ()
+{
+	UnmapViewOfFile(this->data);
+	CloseHandle(this->mapping_handle);
+	CloseHandle(this->file_handle);
+}
+
+#else
+
+MappedFile::MappedFile (const std::string& fname)
+{
+	struct stat st;
+
+	this->fd = open(fname.data(), O_RDONLY);
+	mylib_assert_exception_msg(this->fd >= 0, "cannot open file ", fname)
+
+	if (fstat(this->fd, &st) != 0 || st.st_size == 0) {
+		close(this->fd);
+		mylib_throw_exception_msg("cannot map empty file ", fname);
+	}
+
+	this->size = static_cast<size_t>(st.st_size);
+
+	void *ptr = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+
+	if (ptr == MAP_FAILED) {
+		close(this->fd);
+		mylib_throw_exception_msg("cannot map file ", fname);
+	}
+
+	// we parse the files in a single sequential pass
+	madvise(ptr, this->size, MADV_SEQUENTIAL);
+
+	this->data = static_cast<const char*>(ptr);
+}
+
+MappedFile::~MappedFile ()
+{
+	munmap(const_cast<char*>(this->data), this->size);
+	close(this->fd);
+}
+
+#endif
+
+// ---------------------------------------------------
+
 } // end namespace Game
\ No newline at end of file
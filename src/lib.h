@@ -2,8 +2,10 @@
 #define __PACMAN_SDL_OPENGL_LIB_HEADER_H__
 
 #include <chrono>
-#include <random>
+#include <array>
+#include <utility>
 #include <ostream>
+#include <string>
 
 #include <cmath>
 
@@ -71,13 +73,126 @@ constexpr int32_t round_to_nearest (const float v)
 
 // ---------------------------------------------------
 
-class Probability
+/*
+	Philox4x32-10 counter-based random generator
+	(Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+	The output is a pure function of the counter and the key,
+	so there is no generator state to share between threads.
+*/
+
+class Philox
+{
+public:
+	using Counter = std::array<uint32_t, 4>;
+	using Key = std::array<uint32_t, 2>;
+
+	static constexpr Counter generate (Counter ctr, Key key)
+	{
+		for (uint32_t round = 0; round < 10; round++) {
+			if (round > 0) {
+				key[0] += 0x9E3779B9;
+				key[1] += 0xBB67AE85;
+			}
+
+			const uint64_t p0 = static_cast<uint64_t>(0xD2511F53) * ctr[0];
+			const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57) * ctr[2];
+
+			ctr = Counter {
+				static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+				static_cast<uint32_t>(p1),
+				static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+				static_cast<uint32_t>(p0)
+				};
+		}
+
+		return ctr;
+	}
+};
+
+// ---------------------------------------------------
+
+/*
+	Random numbers of the simulation.
+	Each draw is keyed by the seed and addressed by (stream, entity id, tick),
+	so any entity can draw its numbers for any tick in any thread,
+	and the same seed always gives the same game.
+*/
+
+class Random
+{
+public:
+	enum class Stream : uint32_t {
+		GhostDirection,
+		GhostColor,
+		WallColor
+	};
+
+	using Numbers = Philox::Counter;
+
+protected:
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, seed)
+
+	Philox::Key key;
+
+public:
+	Random (const uint64_t seed_)
+	{
+		this->seed = seed_;
+		this->key = Philox::Key { static_cast<uint32_t>(seed_), static_cast<uint32_t>(seed_ >> 32) };
+	}
+
+	// returns 4 independent random 32-bit numbers
+	inline Numbers get (const Stream stream, const uint32_t entity_id, const uint64_t tick) const
+	{
+		return Philox::generate(Philox::Counter {
+			entity_id,
+			static_cast<uint32_t>(tick),
+			static_cast<uint32_t>(tick >> 32),
+			std::to_underlying(stream)
+			}, this->key);
+	}
+
+	// maps v to [0, 1)
+	static constexpr float to_float (const uint32_t v)
+	{
+		return static_cast<float>(v >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// maps v to [0, n), n > 0
+	static constexpr uint32_t to_range (const uint32_t v, const uint32_t n)
+	{
+		return static_cast<uint32_t>( (static_cast<uint64_t>(v) * n) >> 32 );
+	}
+
+	// a non-deterministic seed, used when the user doesn't give one
+	static uint64_t make_seed ();
+};
+
+// ---------------------------------------------------
+
+/*
+	Read-only memory mapping of a whole file.
+*/
+
+class MappedFile
 {
-private:
-	MYLIB_OO_ENCAPSULATE_OBJ(std::mt19937_64, rgenerator);
+protected:
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(const char*, data)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(size_t, size)
+
+#ifdef _WIN32
+	void *file_handle;
+	void *mapping_handle;
+#else
+	int fd;
+#endif
 
 public:
-	Probability ();
+	MappedFile (const std::string& fname);
+	~MappedFile ();
+
+	MappedFile (const MappedFile&) = delete;
+	MappedFile& operator= (const MappedFile&) = delete;
 };
 
 // ---------------------------------------------------
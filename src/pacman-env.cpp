@@ -0,0 +1,113 @@
+#include <string>
+#include <exception>
+#include <utility>
+
+#include "pacman-env.h"
+#include "vec-env.h"
+#include "thread-pool.h"
+#include "game-world.h"
+#include "debug.h"
+
+
+using namespace Game;
+
+// ---------------------------------------------------
+
+struct pacman_env {
+	ThreadPool pool;
+	VecEnv vec_env;
+	std::string error;
+
+	pacman_env (const Map& map, const uint32_t n_envs, const uint32_t n_threads)
+		: pool( (n_threads > 0) ? n_threads : ThreadPool::get_default_n_workers() ),
+		  vec_env(map, n_envs, &pool)
+	{
+	}
+};
+
+// exceptions must not cross the C interface
+template <typename Tfunc>
+static int call (pacman_env *env, Tfunc&& func)
+{
+	try {
+		func();
+		return 0;
+	}
+	catch (const std::exception& e) {
+		env->error = e.what();
+		return -1;
+	}
+}
+
+// ---------------------------------------------------
+
+pacman_env* pacman_env_create (const char *map_fname, const uint32_t n_envs, const uint32_t n_threads)
+{
+	try {
+		const Map map = (map_fname == nullptr || map_fname[0] == 0) ? Map() : Map(map_fname);
+
+		return new pacman_env(map, n_envs, n_threads);
+	}
+	catch (const std::exception& e) {
+		dprintln("pacman_env_create failed: ", e.what());
+		return nullptr;
+	}
+}
+
+void pacman_env_destroy (pacman_env *env)
+{
+	delete env;
+}
+
+const char* pacman_env_get_error (const pacman_env *env)
+{
+	return env->error.c_str();
+}
+
+uint32_t pacman_env_get_n_envs (const pacman_env *env)
+{
+	return env->vec_env.size();
+}
+
+uint32_t pacman_env_get_map_w (const pacman_env *env)
+{
+	return env->vec_env.get_map_w();
+}
+
+uint32_t pacman_env_get_map_h (const pacman_env *env)
+{
+	return env->vec_env.get_map_h();
+}
+
+uint32_t pacman_env_get_observation_words (const pacman_env *env)
+{
+	return env->vec_env.get_observation_words();
+}
+
+int pacman_env_reset (pacman_env *env, const uint64_t seed, uint64_t *observations)
+{
+	return call(env, [=] {
+		env->vec_env.reset(seed, observations);
+	});
+}
+
+int pacman_env_reset_one (pacman_env *env, const uint32_t i, const uint64_t seed, uint64_t *observation)
+{
+	return call(env, [=] {
+		mylib_assert_exception_msg(i < env->vec_env.size(), "invalid environment ", i)
+
+		env->vec_env.reset(i, seed, observation);
+	});
+}
+
+int pacman_env_step (pacman_env *env, const uint8_t *actions, uint64_t *observations, uint32_t *contacts)
+{
+	static_assert(sizeof(VecEnv::Action) == sizeof(uint8_t));
+
+	return call(env, [=] {
+		for (uint32_t i = 0; i < env->vec_env.size(); i++)
+			mylib_assert_exception_msg(actions[i] <= std::to_underlying(VecEnv::Action::Stopped), "invalid action ", static_cast<uint32_t>(actions[i]), " of environment ", i)
+
+		env->vec_env.step(reinterpret_cast<const VecEnv::Action*>(actions), observations, contacts);
+	});
+}
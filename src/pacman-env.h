@@ -0,0 +1,64 @@
+#ifndef __PACMAN_SDL_OPENGL_PACMAN_ENV_HEADER_H__
+#define __PACMAN_SDL_OPENGL_PACMAN_ENV_HEADER_H__
+
+#include <stdint.h>
+
+// PACMAN_ENV_BUILD is defined when building the library itself
+#if defined(_WIN32)
+	#if defined(PACMAN_ENV_BUILD)
+		#define PACMAN_ENV_API __declspec(dllexport)
+	#else
+		#define PACMAN_ENV_API __declspec(dllimport)
+	#endif
+#elif defined(__GNUC__)
+	#define PACMAN_ENV_API __attribute__((visibility("default")))
+#else
+	#define PACMAN_ENV_API
+#endif
+
+/*
+	C interface of Game::VecEnv, for training agents from other languages.
+	See vec-env.h for the layout of the observations.
+	Actions are the values of Events::MoveData::Direction:
+	0 left, 1 right, 2 up, 3 down, 4 stopped.
+	The functions that can fail return 0 on success and -1 on error,
+	and pacman_env_get_error gives the message of the last error.
+	An environment must be used by a single thread at a time.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pacman_env pacman_env;
+
+// if map_fname is null or empty, the built-in map is used
+// n_threads 0 means one per hardware thread
+// returns null on error
+PACMAN_ENV_API pacman_env* pacman_env_create (const char *map_fname, uint32_t n_envs, uint32_t n_threads);
+
+PACMAN_ENV_API void pacman_env_destroy (pacman_env *env);
+
+PACMAN_ENV_API const char* pacman_env_get_error (const pacman_env *env);
+
+PACMAN_ENV_API uint32_t pacman_env_get_n_envs (const pacman_env *env);
+PACMAN_ENV_API uint32_t pacman_env_get_map_w (const pacman_env *env);
+PACMAN_ENV_API uint32_t pacman_env_get_map_h (const pacman_env *env);
+
+// number of uint64_t of the observation of a single environment
+PACMAN_ENV_API uint32_t pacman_env_get_observation_words (const pacman_env *env);
+
+// observations must hold n_envs observations
+PACMAN_ENV_API int pacman_env_reset (pacman_env *env, uint64_t seed, uint64_t *observations);
+
+// observation must hold a single observation
+PACMAN_ENV_API int pacman_env_reset_one (pacman_env *env, uint32_t i, uint64_t seed, uint64_t *observation);
+
+// actions has n_envs entries, contacts may be null
+PACMAN_ENV_API int pacman_env_step (pacman_env *env, const uint8_t *actions, uint64_t *observations, uint32_t *contacts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,8 +20,27 @@ static Game::Main::InitConfig cfg = {
 	.graphics_type = MyGlib::Graphics::Manager::Type::SDL,
 	.window_width_px = Game::Config::default_window_width_px,
 	.window_height_px = Game::Config::default_window_height_px,
+	.target_fps = Game::Config::target_fps,
+	.frame_pacing = Game::FramePacer::Mode::Hybrid,
 	.fullscreen = false,
 	.zoom = Game::Config::default_zoom,
+	.map_fname = "",
+	.headless = false,
+	.offscreen_video = Game::Main::OffscreenVideo::None,
+	.frame_dump_dir = "",
+	.frame_dump_interval = 1,
+	.headless_ticks = Game::Config::headless_default_ticks,
+	.headless_dt = Game::Config::sim_dt,
+	.batch_worlds = 0,
+	.frame_stats = false,
+	.late_input = false,
+	.threaded_sim = false,
+	.frame_stats_format = Game::FrameStats::Format::Text,
+	.frame_stats_fname = "",
+	.n_threads = 0,
+	.seed = std::nullopt,
+	.record_fname = "",
+	.replay_fname = "",
 };
 
 static bool str_i_equals (const std::string_view& a, const std::string_view& b)
@@ -43,10 +62,11 @@ static void process_args (int argc, char **argv)
 	for (uint32_t i = 0; i < n_types; i++) {
 		renderer_type_strs += MyGlib::Graphics::Manager::get_type_str( static_cast<MyGlib::Graphics::Manager::Type>(i) );
 
-		if (i < (n_types-1))
-			renderer_type_strs += ", ";
+		renderer_type_strs += ", ";
 	}
 
+	renderer_type_strs += "null (no window, the rendering commands are only recorded, for --ticks frames), software (no window, rasterized in memory, for --ticks frames)";
+
 	try {
 		cmd_line_args.add_options()
 			( "help,h", "Help screen" )
@@ -63,6 +83,54 @@ static void process_args (int argc, char **argv)
 			( "zoom",
 				boost::program_options::value<float>()->default_value(cfg.zoom),
 				"Zoom level (should be equal or greater than 1.0)" )
+			( "map",
+				boost::program_options::value<std::string>(),
+				"Map file to load (text or binary). If not set, the built-in map is used" )
+			( "map-to-binary",
+				boost::program_options::value<std::string>(),
+				"Load the map given by --map, save it in the binary format to this file and exit" )
+			( "headless", "Run only the simulation, without window or graphics, as fast as possible" )
+			( "ticks",
+				boost::program_options::value<uint64_t>()->default_value(cfg.headless_ticks),
+				"Number of simulation steps in headless mode, or of frames with the null video" )
+			( "dt",
+				boost::program_options::value<float>()->default_value(cfg.headless_dt),
+				"Simulation step in seconds in headless mode and with the null video" )
+			( "batch",
+				boost::program_options::value<uint32_t>(),
+				"Simulate this many worlds of the same map headless, in parallel, with consecutive seeds starting at --seed, for --ticks steps each" )
+			( "frame-stats",
+				boost::program_options::value<std::string>(),
+				"Report per-phase frame timing percentiles and the input to present latency at exit (F12 reports on demand). Formats: text, csv, json" )
+			( "frame-stats-file",
+				boost::program_options::value<std::string>(),
+				"Write the frame stats report to this file instead of the console" )
+			( "late-input", "Process the input right before each physics step, instead of at the start of the frame" )
+			( "threaded-sim", "Simulate in a thread of its own, overlapped with the rendering of the previous step" )
+			( "fps",
+				boost::program_options::value<float>()->default_value(cfg.target_fps),
+				"Target frames per second" )
+			( "pacing",
+				boost::program_options::value<std::string>()->default_value( Game::FramePacer::enum_class_to_str(cfg.frame_pacing) ),
+				"How to wait for the next frame: Hybrid (sleep, then spin only for the learned wake-up jitter), Sleep, Spin or None (for vsync)" )
+			( "dump-frames",
+				boost::program_options::value<std::string>(),
+				"With the software video, save the frames as PPM images to this directory" )
+			( "dump-every",
+				boost::program_options::value<uint32_t>()->default_value(cfg.frame_dump_interval),
+				"With --dump-frames, save only one of this many frames" )
+			( "threads",
+				boost::program_options::value<uint32_t>(),
+				"Number of threads used by the simulation. By default, one per hardware thread" )
+			( "seed",
+				boost::program_options::value<uint64_t>(),
+				"Seed of the random numbers. The same seed and map always give the same game. By default, a random seed is used" )
+			( "record",
+				boost::program_options::value<std::string>(),
+				"Record the input of the session to this replay file" )
+			( "replay",
+				boost::program_options::value<std::string>(),
+				"Simulate a replay file headless, as fast as possible, and check that it ends in the recorded state. Use the same --map as the recording" )
 			;
 
 		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, cmd_line_args), vm);
@@ -78,7 +146,13 @@ static void process_args (int argc, char **argv)
 			cfg.fullscreen = true;
 		}
 
-		if (vm.count("video")) {
+		if (vm.count("video") && str_i_equals(vm["video"].as<std::string>(), "null")) {
+			cfg.offscreen_video = Game::Main::OffscreenVideo::Null;
+		}
+		else if (vm.count("video") && str_i_equals(vm["video"].as<std::string>(), "software")) {
+			cfg.offscreen_video = Game::Main::OffscreenVideo::Software;
+		}
+		else if (vm.count("video")) {
 			bool valid_type = false;
 
 			for (uint32_t i = 0; i < n_types; i++) {
@@ -110,6 +184,123 @@ static void process_args (int argc, char **argv)
 			if (cfg.zoom < 1.0f)
 				throw std::runtime_error("The zoom must be at least 1.0");
 		}
+
+		if (vm.count("map")) {
+			cfg.map_fname = vm["map"].as<std::string>();
+		}
+
+		if (vm.count("map-to-binary")) {
+			using namespace Game;
+			const Map map = cfg.map_fname.empty() ? Map() : Map(cfg.map_fname);
+			map.save_binary(vm["map-to-binary"].as<std::string>());
+			dprintln("map saved to ", vm["map-to-binary"].as<std::string>());
+			std::exit(EXIT_SUCCESS);
+		}
+
+		if (vm.count("headless")) {
+			cfg.headless = true;
+		}
+
+		if (vm.count("batch")) {
+			cfg.headless = true;
+			cfg.batch_worlds = vm["batch"].as<uint32_t>();
+
+			if (cfg.batch_worlds == 0)
+				throw std::runtime_error("The batch must have at least one world");
+		}
+
+		if (vm.count("ticks")) {
+			cfg.headless_ticks = vm["ticks"].as<uint64_t>();
+		}
+
+		if (vm.count("dt")) {
+			cfg.headless_dt = vm["dt"].as<float>();
+
+			if (cfg.headless_dt <= 0.0f || cfg.headless_dt > Game::Config::max_dt)
+				throw std::runtime_error("The dt must be greater than 0 and at most " + std::to_string(Game::Config::max_dt));
+		}
+
+		if (vm.count("frame-stats")) {
+			const std::string& format = vm["frame-stats"].as<std::string>();
+
+			cfg.frame_stats = true;
+
+			if (str_i_equals(format, "text"))
+				cfg.frame_stats_format = Game::FrameStats::Format::Text;
+			else if (str_i_equals(format, "csv"))
+				cfg.frame_stats_format = Game::FrameStats::Format::Csv;
+			else if (str_i_equals(format, "json"))
+				cfg.frame_stats_format = Game::FrameStats::Format::Json;
+			else
+				throw std::runtime_error("Bad frame stats format!");
+		}
+
+		if (vm.count("frame-stats-file")) {
+			cfg.frame_stats_fname = vm["frame-stats-file"].as<std::string>();
+		}
+
+		if (vm.count("fps")) {
+			cfg.target_fps = vm["fps"].as<float>();
+
+			if (cfg.target_fps < Game::Config::min_fps)
+				throw std::runtime_error("The fps must be at least " + std::to_string(Game::Config::min_fps));
+		}
+
+		if (vm.count("pacing")) {
+			bool valid_mode = false;
+
+			for (uint32_t i = 0; i < Game::FramePacer::n_modes; i++) {
+				const auto mode = static_cast<Game::FramePacer::Mode>(i);
+
+				if ( str_i_equals(vm["pacing"].as<std::string>(), Game::FramePacer::enum_class_to_str(mode)) ) {
+					valid_mode = true;
+					cfg.frame_pacing = mode;
+					break;
+				}
+			}
+
+			if (!valid_mode)
+				throw std::runtime_error("Bad frame pacing!");
+		}
+
+		if (vm.count("late-input")) {
+			cfg.late_input = true;
+		}
+
+		if (vm.count("threaded-sim")) {
+			cfg.threaded_sim = true;
+		}
+
+		if (vm.count("dump-frames")) {
+			cfg.frame_dump_dir = vm["dump-frames"].as<std::string>();
+		}
+
+		if (vm.count("dump-every")) {
+			cfg.frame_dump_interval = vm["dump-every"].as<uint32_t>();
+
+			if (cfg.frame_dump_interval == 0)
+				throw std::runtime_error("The frame dump interval must be greater than 0");
+		}
+
+		if (vm.count("threads")) {
+			cfg.n_threads = vm["threads"].as<uint32_t>();
+
+			if (cfg.n_threads == 0)
+				throw std::runtime_error("The number of threads must be greater than 0");
+		}
+
+		if (vm.count("seed")) {
+			cfg.seed = vm["seed"].as<uint64_t>();
+		}
+
+		if (vm.count("record")) {
+			cfg.record_fname = vm["record"].as<std::string>();
+		}
+
+		if (vm.count("replay")) {
+			cfg.replay_fname = vm["replay"].as<std::string>();
+			cfg.headless = true;
+		}
 	}
 	catch (const boost::program_options::error& ex) {
 		throw std::runtime_error(ex.what());
@@ -123,7 +314,19 @@ int main (const int argc, char **argv)
 	try {
 		process_args(argc, argv);
 
-		dprintln("Setting video renderer to ", MyGlib::Graphics::Manager::get_type_str(cfg.graphics_type));
+		switch (cfg.offscreen_video) {
+			case Main::OffscreenVideo::None:
+				dprintln("Setting video renderer to ", MyGlib::Graphics::Manager::get_type_str(cfg.graphics_type));
+			break;
+
+			case Main::OffscreenVideo::Null:
+				dprintln("Setting video renderer to null");
+			break;
+
+			case Main::OffscreenVideo::Software:
+				dprintln("Setting video renderer to software");
+			break;
+		}
 
 		dprintln("Initializing SDL...");
 		
@@ -0,0 +1,189 @@
+#include <type_traits>
+#include <algorithm>
+
+#include <cstring>
+
+#include "renderer.h"
+#include "debug.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+void Renderer::draw_circles2D (const std::span<const CircleInstance> circles)
+{
+	for (const CircleInstance& circle : circles)
+		this->draw_circle2D(Circle2D(circle.radius), circle.pos, circle.color);
+}
+
+// ---------------------------------------------------
+
+NullRenderer::NullRenderer (const uint32_t window_width_px_, const uint32_t window_height_px_)
+{
+	mylib_assert_exception_msg(window_width_px_ > 0 && window_height_px_ > 0, "invalid window size ", window_width_px_, "x", window_height_px_)
+
+	this->window_width_px = window_width_px_;
+	this->window_height_px = window_height_px_;
+}
+
+Vector NullRenderer::get_normalized_window_size () const
+{
+	return Vector(1.0f, static_cast<float>(this->window_height_px) / static_cast<float>(this->window_width_px));
+}
+
+void NullRenderer::wait_next_frame ()
+{
+}
+
+void NullRenderer::setup_render_2D (const RenderArgs2D& args)
+{
+}
+
+void NullRenderer::draw_rect2D (const Rect2D& rect, const Vector& offset, const Color& color)
+{
+}
+
+void NullRenderer::draw_circle2D (const Circle2D& circle, const Vector& offset, const Color& color)
+{
+}
+
+void NullRenderer::draw_circles2D (const std::span<const CircleInstance> circles)
+{
+}
+
+void NullRenderer::render ()
+{
+}
+
+void NullRenderer::update_screen ()
+{
+}
+
+// ---------------------------------------------------
+
+RecordingRenderer::RecordingRenderer (const uint32_t window_width_px_, const uint32_t window_height_px_)
+	: NullRenderer(window_width_px_, window_height_px_)
+{
+	this->frame = FrameCounters { };
+	this->n_frames = 0;
+	this->total = FrameCounters { };
+	this->max = FrameCounters { };
+}
+
+void RecordingRenderer::append (const void *data, const size_t size)
+{
+	const size_t pos = this->commands.size();
+
+	this->commands.resize(pos + size);
+	std::memcpy(this->commands.data() + pos, data, size);
+}
+
+void RecordingRenderer::pack_color (const Color& color, uint8_t *rgba)
+{
+	auto to_byte = [] (const float v) -> uint8_t {
+		return static_cast<uint8_t>( std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f );
+	};
+
+	rgba[0] = to_byte(color.r);
+	rgba[1] = to_byte(color.g);
+	rgba[2] = to_byte(color.b);
+	rgba[3] = to_byte(color.a);
+}
+
+void RecordingRenderer::setup_render_2D (const RenderArgs2D& args)
+{
+	static_assert(std::is_trivially_copyable_v<RenderArgs2D>);
+
+	const Command cmd = Command::SetupRender2D;
+
+	this->append(&cmd, sizeof(cmd));
+	this->append(&args, sizeof(args));
+}
+
+void RecordingRenderer::draw_rect2D (const Rect2D& rect, const Vector& offset, const Color& color)
+{
+	const Command cmd = Command::DrawRect2D;
+	RectArgs args = { .w = rect.get_w(), .h = rect.get_h(), .x = offset.x, .y = offset.y, .rgba = { } };
+
+	pack_color(color, args.rgba);
+
+	this->append(&cmd, sizeof(cmd));
+	this->append(&args, sizeof(args));
+
+	this->frame.n_draw_calls++;
+	this->frame.n_primitives++;
+}
+
+void RecordingRenderer::draw_circle2D (const Circle2D& circle, const Vector& offset, const Color& color)
+{
+	const Command cmd = Command::DrawCircle2D;
+	CircleArgs args = { .radius = circle.get_radius(), .x = offset.x, .y = offset.y, .rgba = { } };
+
+	pack_color(color, args.rgba);
+
+	this->append(&cmd, sizeof(cmd));
+	this->append(&args, sizeof(args));
+
+	this->frame.n_draw_calls++;
+	this->frame.n_primitives++;
+}
+
+void RecordingRenderer::draw_circles2D (const std::span<const CircleInstance> circles)
+{
+	const Command cmd = Command::DrawCircles2D;
+	const uint32_t n = static_cast<uint32_t>(circles.size());
+
+	this->append(&cmd, sizeof(cmd));
+	this->append(&n, sizeof(n));
+
+	const size_t pos = this->commands.size();
+	this->commands.resize(pos + sizeof(CircleArgs) * n);
+
+	uint8_t *dst = this->commands.data() + pos;
+
+	for (const CircleInstance& circle : circles) {
+		CircleArgs args = { .radius = circle.radius, .x = circle.pos.x, .y = circle.pos.y, .rgba = { } };
+
+		pack_color(circle.color, args.rgba);
+
+		std::memcpy(dst, &args, sizeof(args));
+		dst += sizeof(args);
+	}
+
+	this->frame.n_draw_calls++;
+	this->frame.n_primitives += n;
+}
+
+void RecordingRenderer::update_screen ()
+{
+	this->frame.n_bytes = this->commands.size();
+
+	this->total.n_draw_calls += this->frame.n_draw_calls;
+	this->total.n_primitives += this->frame.n_primitives;
+	this->total.n_bytes += this->frame.n_bytes;
+
+	this->max.n_draw_calls = std::max(this->max.n_draw_calls, this->frame.n_draw_calls);
+	this->max.n_primitives = std::max(this->max.n_primitives, this->frame.n_primitives);
+	this->max.n_bytes = std::max(this->max.n_bytes, this->frame.n_bytes);
+
+	this->n_frames++;
+
+	this->frame = FrameCounters { };
+	this->commands.clear(); // keeps the capacity for the next frame
+}
+
+void RecordingRenderer::report () const
+{
+	const double n = static_cast<double>( std::max(this->n_frames, uint64_t(1)) );
+
+	dprintln("recorded ", this->n_frames, " frames, per frame (mean/max): ",
+		static_cast<double>(this->total.n_draw_calls) / n, "/", this->max.n_draw_calls, " draw calls, ",
+		static_cast<double>(this->total.n_primitives) / n, "/", this->max.n_primitives, " primitives, ",
+		static_cast<double>(this->total.n_bytes) / n, "/", this->max.n_bytes, " bytes");
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
@@ -0,0 +1,216 @@
+#ifndef __PACMAN_SDL_OPENGL_RENDERER_HEADER_H__
+#define __PACMAN_SDL_OPENGL_RENDERER_HEADER_H__
+
+#include <vector>
+#include <span>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include <my-game-lib/my-game-lib.h>
+
+#include "lib.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+using MyGlib::Graphics::Rect2D;
+using MyGlib::Graphics::Circle2D;
+using MyGlib::Graphics::RenderArgs2D;
+
+// ---------------------------------------------------
+
+// one circle of a batch given to Renderer::draw_circles2D
+
+struct CircleInstance {
+	Vector pos; // center
+	float radius;
+	Color color;
+};
+
+// ---------------------------------------------------
+
+/*
+	Everything the game draws goes through this interface,
+	so that the game can render without a video device.
+*/
+
+class Renderer
+{
+public:
+	virtual ~Renderer () = default;
+
+	// the width is 1, the height follows the aspect ratio of the window
+	virtual Vector get_normalized_window_size () const = 0;
+
+	virtual void wait_next_frame () = 0;
+	virtual void setup_render_2D (const RenderArgs2D& args) = 0;
+	virtual void draw_rect2D (const Rect2D& rect, const Vector& offset, const Color& color) = 0;
+	virtual void draw_circle2D (const Circle2D& circle, const Vector& offset, const Color& color) = 0;
+
+	// a single draw of many circles, by default one draw_circle2D per circle
+	virtual void draw_circles2D (const std::span<const CircleInstance> circles);
+
+	virtual void render () = 0;
+	virtual void update_screen () = 0;
+};
+
+// ---------------------------------------------------
+
+/*
+	Draws with the SDL or Opengl renderer of my-game-lib.
+	my-game-lib has no instanced drawing, so batches of circles
+	are drawn one by one.
+*/
+
+class MyGlibRenderer : public Renderer
+{
+protected:
+	MyGlib::Graphics::Manager& manager;
+
+public:
+	MyGlibRenderer (MyGlib::Graphics::Manager& manager_)
+		: manager(manager_)
+	{
+	}
+
+	Vector get_normalized_window_size () const override final
+	{
+		return this->manager.get_normalized_window_size();
+	}
+
+	void wait_next_frame () override final
+	{
+		this->manager.wait_next_frame();
+	}
+
+	void setup_render_2D (const RenderArgs2D& args) override final
+	{
+		this->manager.setup_render_2D(args);
+	}
+
+	void draw_rect2D (const Rect2D& rect, const Vector& offset, const Color& color) override final
+	{
+		this->manager.draw_rect2D(rect, offset, color);
+	}
+
+	void draw_circle2D (const Circle2D& circle, const Vector& offset, const Color& color) override final
+	{
+		this->manager.draw_circle2D(circle, offset, color);
+	}
+
+	void render () override final
+	{
+		this->manager.render();
+	}
+
+	void update_screen () override final
+	{
+		this->manager.update_screen();
+	}
+};
+
+// ---------------------------------------------------
+
+// discards everything, for benchmarks of the game side of rendering
+
+class NullRenderer : public Renderer
+{
+protected:
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, window_width_px)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, window_height_px)
+
+public:
+	NullRenderer (const uint32_t window_width_px_, const uint32_t window_height_px_);
+
+	Vector get_normalized_window_size () const override;
+	void wait_next_frame () override;
+	void setup_render_2D (const RenderArgs2D& args) override;
+	void draw_rect2D (const Rect2D& rect, const Vector& offset, const Color& color) override;
+	void draw_circle2D (const Circle2D& circle, const Vector& offset, const Color& color) override;
+	void draw_circles2D (const std::span<const CircleInstance> circles) override;
+	void render () override;
+	void update_screen () override;
+};
+
+// ---------------------------------------------------
+
+/*
+	Draws nothing, but records the commands of each frame into a
+	compact byte buffer, as a GPU backend would before submitting.
+	Each command is its Command byte followed by its arguments:
+	RenderArgs2D, RectArgs, CircleArgs, or for DrawCircles2D the
+	number of circles (uint32_t) followed by a CircleArgs per circle.
+	Colors are packed as RGBA8.
+	The buffer is cleared at update_screen, after the counters of
+	the frame are accumulated.
+*/
+
+class RecordingRenderer : public NullRenderer
+{
+public:
+	enum class Command : uint8_t {
+		SetupRender2D,
+		DrawRect2D,
+		DrawCircle2D,
+		DrawCircles2D
+	};
+
+	struct RectArgs {
+		float w;
+		float h;
+		float x; // center
+		float y;
+		uint8_t rgba[4];
+	};
+
+	struct CircleArgs {
+		float radius;
+		float x; // center
+		float y;
+		uint8_t rgba[4];
+	};
+
+	struct FrameCounters {
+		uint64_t n_draw_calls;
+		uint64_t n_primitives;
+		uint64_t n_bytes;
+	};
+
+protected:
+	std::vector<uint8_t> commands;
+	FrameCounters frame;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_frames)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(FrameCounters, total)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(FrameCounters, max)
+
+public:
+	RecordingRenderer (const uint32_t window_width_px_, const uint32_t window_height_px_);
+
+	void setup_render_2D (const RenderArgs2D& args) override;
+	void draw_rect2D (const Rect2D& rect, const Vector& offset, const Color& color) override;
+	void draw_circle2D (const Circle2D& circle, const Vector& offset, const Color& color) override;
+	void draw_circles2D (const std::span<const CircleInstance> circles) override;
+	void update_screen () override;
+
+	// commands of the frame being recorded
+	inline const std::vector<uint8_t>& get_ref_commands () const
+	{
+		return this->commands;
+	}
+
+	void report () const;
+
+protected:
+	void append (const void *data, const size_t size);
+	static void pack_color (const Color& color, uint8_t *rgba);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <fstream>
+#include <bit>
+#include <utility>
+
+#include <cstring>
+
+#include "debug.h"
+#include "replay.h"
+#include "game-world.h"
+#include "lib.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+static void append_uint_le (std::vector<uint8_t>& buffer, const uint64_t v, const uint32_t n_bytes)
+{
+	for (uint32_t i = 0; i < n_bytes; i++)
+		buffer.push_back( static_cast<uint8_t>(v >> (8 * i)) );
+}
+
+static void append_varint (std::vector<uint8_t>& buffer, uint64_t v)
+{
+	while (v >= 0x80) {
+		buffer.push_back( static_cast<uint8_t>(v | 0x80) );
+		v >>= 7;
+	}
+
+	buffer.push_back( static_cast<uint8_t>(v) );
+}
+
+static uint64_t read_uint_le (const uint8_t *data, const uint32_t n_bytes)
+{
+	uint64_t v = 0;
+
+	for (uint32_t i = 0; i < n_bytes; i++)
+		v |= static_cast<uint64_t>(data[i]) << (8 * i);
+
+	return v;
+}
+
+// ---------------------------------------------------
+
+Replay::Replay (const std::string& fname)
+{
+	const MappedFile file(fname);
+	const auto *data = reinterpret_cast<const uint8_t*>(file.get_data());
+	const size_t size = file.get_size();
+
+	mylib_assert_exception_msg(size >= header_size && std::memcmp(data, magic, sizeof(magic)) == 0, "invalid replay file ", fname)
+
+	const uint32_t file_version = static_cast<uint32_t>( read_uint_le(data + 4, 4) );
+	mylib_assert_exception_msg(file_version == version, "unsupported replay version ", file_version)
+
+	this->seed = read_uint_le(data + 8, 8);
+	this->map_hash = read_uint_le(data + 16, 8);
+	this->dt = std::bit_cast<float>( static_cast<uint32_t>( read_uint_le(data + 24, 4) ) );
+
+	mylib_assert_exception_msg(this->dt > 0.0f, "invalid replay dt ", this->dt)
+
+	size_t pos = header_size;
+	uint64_t tick = 0;
+
+	while (true) {
+		uint64_t v = 0;
+		uint32_t shift = 0;
+
+		while (true) {
+			mylib_assert_exception_msg(pos < size && shift < 64, "invalid replay file ", fname, ", truncated moves")
+
+			const uint8_t b = data[pos++];
+			v |= static_cast<uint64_t>(b & 0x7F) << shift;
+			shift += 7;
+
+			if (!(b & 0x80))
+				break;
+		}
+
+		const uint8_t direction = static_cast<uint8_t>(v & 0x07);
+		tick += v >> 3;
+
+		if (direction == end_marker)
+			break;
+
+		mylib_assert_exception_msg(direction <= std::to_underlying(Direction::Stopped), "invalid replay direction ", static_cast<uint32_t>(direction))
+
+		this->moves.push_back( Move { .tick = tick, .direction = static_cast<Direction>(direction) } );
+	}
+
+	mylib_assert_exception_msg((pos + 8) == size, "invalid replay file ", fname, ", bad trailer")
+
+	this->n_ticks = tick;
+	this->state_hash = read_uint_le(data + pos, 8);
+
+	dprintln("loaded replay ", fname, " (", this->moves.size(), " moves, ", this->n_ticks, " ticks)");
+}
+
+// ---------------------------------------------------
+
+ReplayRecorder::ReplayRecorder (World& world_, const float dt)
+	: world(world_)
+{
+	for (const char c : Replay::magic)
+		this->buffer.push_back( static_cast<uint8_t>(c) );
+
+	append_uint_le(this->buffer, Replay::version, 4);
+	append_uint_le(this->buffer, this->world.get_ref_random().get_seed(), 8);
+	append_uint_le(this->buffer, this->world.get_ref_map().get_hash(), 8);
+	append_uint_le(this->buffer, std::bit_cast<uint32_t>(dt), 4);
+
+	this->last_tick = this->world.get_n_ticks();
+
+	this->event_move_d = this->world.get_ref_context().move.subscribe( Mylib::Event::make_callback_object<Events::Move::Type>(*this, &ReplayRecorder::event_move) );
+}
+
+ReplayRecorder::~ReplayRecorder ()
+{
+	this->world.get_ref_context().move.unsubscribe(this->event_move_d);
+}
+
+void ReplayRecorder::event_move (const Events::Move::Type& move_data)
+{
+	const uint64_t tick = this->world.get_n_ticks();
+
+	append_varint(this->buffer, ((tick - this->last_tick) << 3) | std::to_underlying(move_data.direction));
+	this->last_tick = tick;
+}
+
+void ReplayRecorder::save (const std::string& fname)
+{
+	const uint64_t tick = this->world.get_n_ticks();
+
+	append_varint(this->buffer, ((tick - this->last_tick) << 3) | Replay::end_marker);
+	append_uint_le(this->buffer, this->world.get_state_hash(), 8);
+	this->last_tick = tick;
+
+	std::ofstream out(fname, std::ios::binary);
+	mylib_assert_exception_msg(out.is_open(), "cannot open ", fname)
+
+	out.write(reinterpret_cast<const char*>(this->buffer.data()), static_cast<std::streamsize>(this->buffer.size()));
+
+	mylib_assert_exception_msg(out.good(), "error writing ", fname)
+
+	dprintln("replay saved to ", fname, " (", this->buffer.size(), " bytes, ", tick, " ticks)");
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
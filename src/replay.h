@@ -0,0 +1,93 @@
+#ifndef __PACMAN_SDL_OPENGL_REPLAY_HEADER_H__
+#define __PACMAN_SDL_OPENGL_REPLAY_HEADER_H__
+
+#include <vector>
+#include <string>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "events.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+class World;
+
+// ---------------------------------------------------
+
+/*
+	Replay files store the player input of a session, so that the
+	same game can be simulated again bit-for-bit.
+	All integers are little-endian.
+
+	- The magic "PRPL" and the version (uint32_t).
+	- The seed (uint64_t), the map hash (uint64_t) and the dt of
+	  the simulation steps (float bits, uint32_t).
+	- One varint per Events::move publication, with the value
+	  (tick_delta << 3) | direction, where tick_delta is the number
+	  of ticks since the previous publication.
+	- A last varint with the direction end_marker, whose tick_delta
+	  gives the total number of ticks, followed by the hash of the
+	  world state at the end of the session (uint64_t).
+*/
+
+class Replay
+{
+public:
+	using Direction = Events::MoveData::Direction;
+
+	struct Move {
+		uint64_t tick;
+		Direction direction;
+	};
+
+	static constexpr char magic[4] = { 'P', 'R', 'P', 'L' };
+	static constexpr uint32_t version = 1;
+	static constexpr uint32_t header_size = 28;
+	static constexpr uint8_t end_marker = 7;
+
+protected:
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, seed)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, map_hash)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(float, dt)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_ticks)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, state_hash)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<Move>, moves)
+
+public:
+	Replay (const std::string& fname);
+};
+
+// ---------------------------------------------------
+
+/*
+	Records every Events::move publication, tagged with the tick
+	of the world in which it will take effect.
+*/
+
+class ReplayRecorder
+{
+protected:
+	World& world;
+	std::vector<uint8_t> buffer;
+	uint64_t last_tick;
+	Events::Move::Descriptor event_move_d;
+
+public:
+	ReplayRecorder (World& world_, const float dt);
+	~ReplayRecorder ();
+
+	// appends the end of the stream and writes the file
+	void save (const std::string& fname);
+
+	void event_move (const Events::Move::Type& move_data);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
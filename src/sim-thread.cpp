@@ -0,0 +1,90 @@
+#include "sim-thread.h"
+#include "config.h"
+#include "debug.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+SimulationThread::SimulationThread (World& world_)
+	: world(world_)
+{
+	this->n_inputs = 0;
+	this->n_ticks = 0;
+	this->n_dropped_ticks = 0;
+	this->stop = false;
+
+	// so that the main thread has something to render from the start
+	this->publish_snapshot( Clock::now() );
+
+	this->thread = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread ()
+{
+	this->stop = true;
+	this->thread.join();
+
+	dprintln("simulation thread finished: ", this->n_ticks, " ticks, ", this->n_dropped_ticks, " dropped");
+}
+
+void SimulationThread::push_input (const Events::MoveData& move)
+{
+	std::lock_guard<std::mutex> lock(this->input_mutex);
+
+	this->inputs.push_back(move);
+}
+
+void SimulationThread::publish_snapshot (const ClockTime time)
+{
+	World::Snapshot& snapshot = this->snapshots.get_back();
+
+	this->world.fill_snapshot(snapshot);
+	snapshot.time = time;
+	snapshot.n_inputs = this->n_inputs;
+
+	this->snapshots.publish();
+}
+
+void SimulationThread::run ()
+{
+	constexpr ClockDuration dt = float_to_ClockDuration(Config::sim_dt);
+	constexpr ClockDuration max_delay = dt * Config::max_sim_steps_per_frame;
+	ClockTime tnext = Clock::now();
+
+	while (!this->stop) {
+		tnext += dt;
+
+		// if we could not catch up, we drop the remaining time, as the single-threaded loop does
+		const ClockTime now = Clock::now();
+
+		if ((now - tnext) > max_delay) {
+			this->n_dropped_ticks += static_cast<uint64_t>((now - tnext) / dt);
+			tnext = now;
+		}
+
+		std::this_thread::sleep_until(tnext);
+
+		{
+			std::lock_guard<std::mutex> lock(this->input_mutex);
+			this->inputs.swap(this->inputs_to_simulate);
+		}
+
+		for (const Events::MoveData& move : this->inputs_to_simulate)
+			this->world.get_ref_context().move.publish(move);
+
+		this->n_inputs += this->inputs_to_simulate.size();
+		this->inputs_to_simulate.clear();
+
+		this->world.step(Config::sim_dt, nullptr);
+		this->n_ticks++;
+
+		this->publish_snapshot(tnext);
+	}
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef __PACMAN_SDL_OPENGL_SIM_THREAD_HEADER_H__
+#define __PACMAN_SDL_OPENGL_SIM_THREAD_HEADER_H__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "lib.h"
+#include "events.h"
+#include "triple-buffer.h"
+#include "game-world.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Simulates the world in its own thread, in steps of Config::sim_dt
+	in real time, so that the simulation of a tick overlaps with the
+	rendering of the previous one.
+	After every tick, a World::Snapshot is published in a triple
+	buffer, from which the main thread renders the latest one.
+	The input of the main thread is queued and published as
+	Events::move in the simulation thread, before the next tick.
+	While this thread runs, only it may touch the world, except for
+	World::render_snapshot.
+*/
+
+class SimulationThread
+{
+protected:
+	World& world;
+	TripleBuffer<World::Snapshot> snapshots;
+
+	std::mutex input_mutex;
+	std::vector<Events::MoveData> inputs; // protected by input_mutex
+	std::vector<Events::MoveData> inputs_to_simulate; // simulation thread only
+	uint64_t n_inputs; // simulation thread only
+
+	std::atomic<bool> stop;
+	std::thread thread;
+
+	// the simulation thread writes these, read them only after the thread stops
+	uint64_t n_ticks;
+	uint64_t n_dropped_ticks; // could not catch up
+
+public:
+	// starts the thread
+	SimulationThread (World& world_);
+
+	// stops the thread
+	~SimulationThread ();
+
+	// main thread
+	void push_input (const Events::MoveData& move);
+
+	// main thread, the snapshot is valid until the next call
+	inline const World::Snapshot& acquire_snapshot ()
+	{
+		return this->snapshots.acquire();
+	}
+
+protected:
+	void run ();
+	void publish_snapshot (const ClockTime time);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
@@ -0,0 +1,347 @@
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+
+#include <cstring>
+#include <cmath>
+
+#include "software-renderer.h"
+#include "debug.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+static constexpr uint32_t background_color = 0xFF000000; // opaque black
+
+static inline uint32_t rgba_to_uint (const uint8_t *rgba)
+{
+	return static_cast<uint32_t>(rgba[0])
+	    | (static_cast<uint32_t>(rgba[1]) << 8)
+	    | (static_cast<uint32_t>(rgba[2]) << 16)
+	    | (static_cast<uint32_t>(rgba[3]) << 24);
+}
+
+// first pixel whose center is at or after the coordinate v
+static inline int32_t first_pixel (const float v)
+{
+	constexpr float limit = 1.0e9f; // far outside of any window, but fits in int32_t
+
+	return static_cast<int32_t>( std::ceil( std::clamp(v - 0.5f, -limit, limit) ) );
+}
+
+static void fill_span (uint32_t *dst, const int32_t n, const uint32_t color)
+{
+	std::fill_n(dst, n, color);
+}
+
+// dst = src * a + dst * (1 - a), per channel, keeping dst opaque
+
+static void blend_span (uint32_t *dst, const int32_t n, const uint32_t color)
+{
+	const uint32_t a = color >> 24;
+	const uint32_t inv_a = 255 - a;
+	const uint32_t sr = (color & 0xFF) * a;
+	const uint32_t sg = ((color >> 8) & 0xFF) * a;
+	const uint32_t sb = ((color >> 16) & 0xFF) * a;
+
+	for (int32_t i = 0; i < n; i++) {
+		const uint32_t d = dst[i];
+		const uint32_t r = (sr + (d & 0xFF) * inv_a + 127) / 255;
+		const uint32_t g = (sg + ((d >> 8) & 0xFF) * inv_a + 127) / 255;
+		const uint32_t b = (sb + ((d >> 16) & 0xFF) * inv_a + 127) / 255;
+
+		dst[i] = r | (g << 8) | (b << 16) | 0xFF000000;
+	}
+}
+
+// ---------------------------------------------------
+
+SoftwareRenderer::SoftwareRenderer (const uint32_t window_width_px_, const uint32_t window_height_px_, const std::string& dump_dir_, const uint32_t dump_interval_)
+	: RecordingRenderer(window_width_px_, window_height_px_),
+	  dump_dir(dump_dir_),
+	  dump_interval(std::max(dump_interval_, 1u))
+{
+	this->thread_pool = nullptr;
+
+	this->framebuffer.resize(static_cast<size_t>(this->window_width_px) * this->window_height_px, background_color);
+
+	this->n_tiles_x = (this->window_width_px + tile_size - 1) / tile_size;
+	this->n_tiles_y = (this->window_height_px + tile_size - 1) / tile_size;
+
+	this->bins.resize(this->n_tiles_x * this->n_tiles_y);
+
+	if (!this->dump_dir.empty())
+		std::filesystem::create_directories(this->dump_dir);
+}
+
+/*
+	Same camera as the my-game-lib renderers: the clip area is given
+	in normalized window coordinates (the window width is 1), and shows
+	world_screen_width world units around the camera focus, kept inside
+	the world if force_camera_inside_world is set.
+*/
+
+SoftwareRenderer::Transform SoftwareRenderer::make_transform (const RenderArgs2D& args) const
+{
+	const float window_w = static_cast<float>(this->window_width_px);
+
+	const float clip_x0 = args.clip_init_norm.x * window_w;
+	const float clip_y0 = args.clip_init_norm.y * window_w;
+	const float clip_x1 = args.clip_end_norm.x * window_w;
+	const float clip_y1 = args.clip_end_norm.y * window_w;
+
+	const float scale = (clip_x1 - clip_x0) / args.world_screen_width;
+	const float view_w = args.world_screen_width;
+	const float view_h = (clip_y1 - clip_y0) / scale;
+
+	auto view_begin = [&args] (const float focus, const float view_size, const float world_init, const float world_end) -> float {
+		const float begin = focus - view_size * 0.5f;
+
+		if (!args.force_camera_inside_world)
+			return begin;
+		else if (view_size >= (world_end - world_init))
+			return world_init;
+		else
+			return std::clamp(begin, world_init, world_end - view_size);
+	};
+
+	return Transform {
+		.scale = scale,
+		.world_x = view_begin(args.world_camera_focus.x, view_w, args.world_init.x, args.world_end.x),
+		.world_y = view_begin(args.world_camera_focus.y, view_h, args.world_init.y, args.world_end.y),
+		.screen_x = clip_x0,
+		.screen_y = clip_y0,
+		.clip_x_begin = std::max(first_pixel(clip_x0), 0),
+		.clip_x_end = std::min(first_pixel(clip_x1), static_cast<int32_t>(this->window_width_px)),
+		.clip_y_begin = std::max(first_pixel(clip_y0), 0),
+		.clip_y_end = std::min(first_pixel(clip_y1), static_cast<int32_t>(this->window_height_px))
+	};
+}
+
+/*
+	Decodes the commands of the frame into screen-space primitives,
+	and appends each one to the bins of the tiles it overlaps.
+*/
+
+void SoftwareRenderer::bin_primitives ()
+{
+	const uint8_t *data = this->commands.data();
+	const size_t size = this->commands.size();
+	size_t pos = 0;
+
+	// until the first setup_render_2D, world and screen are the same
+	Transform t = {
+		.scale = 1.0f,
+		.world_x = 0.0f,
+		.world_y = 0.0f,
+		.screen_x = 0.0f,
+		.screen_y = 0.0f,
+		.clip_x_begin = 0,
+		.clip_x_end = static_cast<int32_t>(this->window_width_px),
+		.clip_y_begin = 0,
+		.clip_y_end = static_cast<int32_t>(this->window_height_px)
+	};
+
+	this->primitives.clear();
+
+	for (std::vector<uint32_t>& bin : this->bins)
+		bin.clear();
+
+	auto add = [this, &t] (Primitive& p, const float x0, const float y0, const float x1, const float y1) {
+		p.x_begin = std::max(first_pixel(x0), t.clip_x_begin);
+		p.x_end = std::min(first_pixel(x1), t.clip_x_end);
+		p.y_begin = std::max(first_pixel(y0), t.clip_y_begin);
+		p.y_end = std::min(first_pixel(y1), t.clip_y_end);
+
+		if (p.x_begin >= p.x_end || p.y_begin >= p.y_end)
+			return;
+
+		const uint32_t id = static_cast<uint32_t>(this->primitives.size());
+		this->primitives.push_back(p);
+
+		constexpr int32_t ts = tile_size;
+
+		for (int32_t ty = p.y_begin / ts; ty <= (p.y_end - 1) / ts; ty++) {
+			for (int32_t tx = p.x_begin / ts; tx <= (p.x_end - 1) / ts; tx++)
+				this->bins[ty * this->n_tiles_x + tx].push_back(id);
+		}
+	};
+
+	auto add_circle = [&add, &t] (const CircleArgs& args) {
+		const float r = args.radius * t.scale;
+
+		Primitive p = { };
+		p.type = Command::DrawCircle2D;
+		p.cx = t.screen_x + (args.x - t.world_x) * t.scale;
+		p.cy = t.screen_y + (args.y - t.world_y) * t.scale;
+		p.radius_sq = r * r;
+		p.color = rgba_to_uint(args.rgba);
+
+		add(p, p.cx - r, p.cy - r, p.cx + r, p.cy + r);
+	};
+
+	while (pos < size) {
+		Command cmd;
+		std::memcpy(&cmd, data + pos, sizeof(cmd));
+		pos += sizeof(cmd);
+
+		switch (cmd) {
+			case Command::SetupRender2D: {
+				RenderArgs2D args;
+				std::memcpy(&args, data + pos, sizeof(args));
+				pos += sizeof(args);
+
+				t = this->make_transform(args);
+			}
+			break;
+
+			case Command::DrawRect2D: {
+				RectArgs args;
+				std::memcpy(&args, data + pos, sizeof(args));
+				pos += sizeof(args);
+
+				const float sx = t.screen_x + (args.x - t.world_x) * t.scale;
+				const float sy = t.screen_y + (args.y - t.world_y) * t.scale;
+				const float hw = args.w * t.scale * 0.5f;
+				const float hh = args.h * t.scale * 0.5f;
+
+				Primitive p = { };
+				p.type = Command::DrawRect2D;
+				p.color = rgba_to_uint(args.rgba);
+
+				add(p, sx - hw, sy - hh, sx + hw, sy + hh);
+			}
+			break;
+
+			case Command::DrawCircle2D: {
+				CircleArgs args;
+				std::memcpy(&args, data + pos, sizeof(args));
+				pos += sizeof(args);
+
+				add_circle(args);
+			}
+			break;
+
+			case Command::DrawCircles2D: {
+				uint32_t n;
+				std::memcpy(&n, data + pos, sizeof(n));
+				pos += sizeof(n);
+
+				for (uint32_t i = 0; i < n; i++) {
+					CircleArgs args;
+					std::memcpy(&args, data + pos, sizeof(args));
+					pos += sizeof(args);
+
+					add_circle(args);
+				}
+			}
+			break;
+
+			default:
+				mylib_throw_exception_msg("invalid render command ", static_cast<uint32_t>(cmd));
+		}
+	}
+}
+
+void SoftwareRenderer::rasterize_tile (const uint32_t tile)
+{
+	const int32_t width = static_cast<int32_t>(this->window_width_px);
+	const int32_t tx_begin = static_cast<int32_t>((tile % this->n_tiles_x) * tile_size);
+	const int32_t ty_begin = static_cast<int32_t>((tile / this->n_tiles_x) * tile_size);
+	const int32_t tx_end = std::min(tx_begin + static_cast<int32_t>(tile_size), width);
+	const int32_t ty_end = std::min(ty_begin + static_cast<int32_t>(tile_size), static_cast<int32_t>(this->window_height_px));
+	uint32_t *pixels = this->framebuffer.data();
+
+	for (int32_t y = ty_begin; y < ty_end; y++)
+		fill_span(pixels + y * width + tx_begin, tx_end - tx_begin, background_color);
+
+	for (const uint32_t id : this->bins[tile]) {
+		const Primitive& p = this->primitives[id];
+		const auto span = ((p.color >> 24) == 0xFF) ? &fill_span : &blend_span;
+		const int32_t x_begin = std::max(p.x_begin, tx_begin);
+		const int32_t x_end = std::min(p.x_end, tx_end);
+		const int32_t y_begin = std::max(p.y_begin, ty_begin);
+		const int32_t y_end = std::min(p.y_end, ty_end);
+
+		if (p.type == Command::DrawRect2D) {
+			for (int32_t y = y_begin; y < y_end; y++)
+				span(pixels + y * width + x_begin, x_end - x_begin, p.color);
+		}
+		else {
+			for (int32_t y = y_begin; y < y_end; y++) {
+				const float dy = (static_cast<float>(y) + 0.5f) - p.cy;
+				const float dx_sq = p.radius_sq - dy * dy;
+
+				if (dx_sq < 0.0f)
+					continue;
+
+				// the edges of the circle in this row
+				const float half = std::sqrt(dx_sq);
+				const int32_t row_begin = std::max(first_pixel(p.cx - half), x_begin);
+				const int32_t row_end = std::min(first_pixel(p.cx + half), x_end);
+
+				if (row_begin < row_end)
+					span(pixels + y * width + row_begin, row_end - row_begin, p.color);
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::render ()
+{
+	this->bin_primitives();
+
+	const uint32_t n_tiles = this->n_tiles_x * this->n_tiles_y;
+
+	if (this->thread_pool != nullptr)
+		this->thread_pool->parallel_for(n_tiles, [this] (const uint32_t tile, const uint32_t) { this->rasterize_tile(tile); });
+	else {
+		for (uint32_t tile = 0; tile < n_tiles; tile++)
+			this->rasterize_tile(tile);
+	}
+}
+
+void SoftwareRenderer::update_screen ()
+{
+	if (!this->dump_dir.empty() && (this->n_frames % this->dump_interval) == 0) {
+		std::ostringstream fname;
+		fname << "frame-" << std::setw(6) << std::setfill('0') << this->n_frames << ".ppm";
+
+		this->save_ppm( (std::filesystem::path(this->dump_dir) / fname.str()).string() );
+	}
+
+	this->RecordingRenderer::update_screen();
+}
+
+void SoftwareRenderer::save_ppm (const std::string& fname) const
+{
+	std::ofstream out(fname, std::ios::binary);
+	mylib_assert_exception_msg(out.is_open(), "cannot open ", fname)
+
+	out << "P6\n" << this->window_width_px << ' ' << this->window_height_px << "\n255\n";
+
+	std::vector<uint8_t> row(this->window_width_px * 3);
+
+	for (uint32_t y = 0; y < this->window_height_px; y++) {
+		const uint32_t *pixels = this->framebuffer.data() + static_cast<size_t>(y) * this->window_width_px;
+
+		for (uint32_t x = 0; x < this->window_width_px; x++) {
+			row[x*3 + 0] = static_cast<uint8_t>(pixels[x]);
+			row[x*3 + 1] = static_cast<uint8_t>(pixels[x] >> 8);
+			row[x*3 + 2] = static_cast<uint8_t>(pixels[x] >> 16);
+		}
+
+		out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+	}
+
+	mylib_assert_exception_msg(out.good(), "error writing ", fname)
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
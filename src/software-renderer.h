@@ -0,0 +1,99 @@
+#ifndef __PACMAN_SDL_OPENGL_SOFTWARE_RENDERER_HEADER_H__
+#define __PACMAN_SDL_OPENGL_SOFTWARE_RENDERER_HEADER_H__
+
+#include <vector>
+#include <string>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "config.h"
+#include "renderer.h"
+#include "thread-pool.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Rasterizes the recorded commands of each frame into an RGBA8
+	framebuffer in memory, without any video device.
+
+	At render, the commands are transformed to screen space and
+	binned into square tiles, which are then rasterized in parallel
+	by the thread pool, each tile by a single task, keeping the
+	submission order inside the tile.
+	Rects and circles are rasterized row by row: the edges give the
+	covered span of each row, which is filled (or blended, if the
+	color is translucent) by loops simple enough to be vectorized
+	by the compiler.
+	A pixel is covered if its center is inside the primitive.
+
+	If dump_dir is not empty, every dump_interval frames the
+	framebuffer is written to dump_dir as a binary PPM.
+*/
+
+class SoftwareRenderer : public RecordingRenderer
+{
+public:
+	static constexpr uint32_t tile_size = Config::software_renderer_tile_size;
+
+protected:
+	// a primitive in screen space, clipped to the scissor of its setup_render_2D
+	struct Primitive {
+		Command type;
+		int32_t x_begin; // pixels
+		int32_t x_end;
+		int32_t y_begin;
+		int32_t y_end;
+		float cx; // circles only
+		float cy;
+		float radius_sq;
+		uint32_t color;
+	};
+
+	// the mapping from world to screen given by setup_render_2D
+	struct Transform {
+		float scale; // pixels per world unit
+		float world_x; // world position at the screen position (screen_x, screen_y)
+		float world_y;
+		float screen_x;
+		float screen_y;
+		int32_t clip_x_begin; // scissor, in pixels
+		int32_t clip_x_end;
+		int32_t clip_y_begin;
+		int32_t clip_y_end;
+	};
+
+	MYLIB_OO_ENCAPSULATE_PTR(ThreadPool*, thread_pool)
+	MYLIB_OO_ENCAPSULATE_OBJ_READONLY(std::vector<uint32_t>, framebuffer) // RGBA8, row-major
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, n_tiles_x)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, n_tiles_y)
+
+	std::string dump_dir;
+	uint32_t dump_interval;
+
+	std::vector<Primitive> primitives;
+	std::vector< std::vector<uint32_t> > bins; // primitive indexes per tile
+
+public:
+	SoftwareRenderer (const uint32_t window_width_px_, const uint32_t window_height_px_, const std::string& dump_dir_, const uint32_t dump_interval_);
+
+	void render () override;
+	void update_screen () override;
+
+	void save_ppm (const std::string& fname) const;
+
+protected:
+	void bin_primitives ();
+	void rasterize_tile (const uint32_t tile);
+
+	Transform make_transform (const RenderArgs2D& args) const;
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
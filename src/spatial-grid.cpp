@@ -0,0 +1,36 @@
+#include "spatial-grid.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+SpatialGrid::SpatialGrid ()
+{
+	this->w = 0;
+	this->h = 0;
+}
+
+void SpatialGrid::reset (const uint32_t w_, const uint32_t h_, const uint32_t n_entities)
+{
+	mylib_assert_exception_msg(w_ > 0 && h_ > 0, "invalid spatial grid size ", w_, "x", h_)
+
+	this->w = w_;
+	this->h = h_;
+
+	this->head.assign(static_cast<size_t>(w_) * static_cast<size_t>(h_), none);
+	this->next.assign(n_entities, none);
+	this->prev.assign(n_entities, none);
+	this->tile_of.assign(n_entities, none);
+}
+
+void SpatialGrid::remove (const uint32_t id)
+{
+	if (this->tile_of[id] != none)
+		this->unlink(id);
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
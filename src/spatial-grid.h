@@ -0,0 +1,224 @@
+#ifndef __PACMAN_SDL_OPENGL_SPATIAL_GRID_HEADER_H__
+#define __PACMAN_SDL_OPENGL_SPATIAL_GRID_HEADER_H__
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <cmath>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "config.h"
+#include "lib.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Buckets entities by the map tile they are in.
+	Each tile keeps an intrusive doubly-linked list of entity ids,
+	so moving an entity to another tile is O(1).
+	Entities are identified by indices in [0, n_entities).
+*/
+
+class SpatialGrid
+{
+public:
+	static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+protected:
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, w)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, h)
+
+	std::vector<uint32_t> head; // per tile, first entity in the tile
+	std::vector<uint32_t> next; // per entity
+	std::vector<uint32_t> prev; // per entity
+	std::vector<uint32_t> tile_of; // per entity
+
+public:
+	SpatialGrid ();
+
+	// removes all entities
+	void reset (const uint32_t w_, const uint32_t h_, const uint32_t n_entities);
+
+	inline uint32_t get_tile (const Vector& pos) const
+	{
+		return this->clamp_y( std::floor(pos.y) ) * this->w + this->clamp_x( std::floor(pos.x) );
+	}
+
+	// inserts the entity if it is not in the grid yet,
+	// or moves it to another tile if it changed tile
+	inline void update (const uint32_t id, const Vector& pos)
+	{
+		const uint32_t tile = this->get_tile(pos);
+
+		if (tile == this->tile_of[id])
+			return;
+
+		if (this->tile_of[id] != none)
+			this->unlink(id);
+
+		this->link(id, tile);
+	}
+
+	void remove (const uint32_t id);
+
+	// calls func(id) for every entity in the tiles [x_begin, x_end) x [y_begin, y_end)
+	template <typename Tfunc>
+	void for_each_in_tiles (const uint32_t x_begin, const uint32_t y_begin, const uint32_t x_end, const uint32_t y_end, Tfunc&& func) const
+	{
+		for (uint32_t y = y_begin; y < y_end; y++) {
+			for (uint32_t x = x_begin; x < x_end; x++) {
+				for (uint32_t id = this->head[y * this->w + x]; id != none; id = this->next[id])
+					func(id);
+			}
+		}
+	}
+
+	/*
+		Calls func(id, distance_squared) for every entity whose position
+		is at most radius away from pos.
+		get_pos(id) must return the position of the entity.
+	*/
+	template <typename Tget_pos, typename Tfunc>
+	void for_each_in_radius (const Vector& pos, const float radius, Tget_pos&& get_pos, Tfunc&& func) const
+	{
+		const float radius_sq = radius * radius;
+
+		const uint32_t x_begin = this->clamp_x( std::floor(pos.x - radius) );
+		const uint32_t y_begin = this->clamp_y( std::floor(pos.y - radius) );
+		const uint32_t x_end = this->clamp_x( std::floor(pos.x + radius) ) + 1;
+		const uint32_t y_end = this->clamp_y( std::floor(pos.y + radius) ) + 1;
+
+		this->for_each_in_tiles(x_begin, y_begin, x_end, y_end, [&] (const uint32_t id) {
+			const Vector d = get_pos(id) - pos;
+			const float distance_sq = d.x*d.x + d.y*d.y;
+
+			if (distance_sq <= radius_sq)
+				func(id, distance_sq);
+		});
+	}
+
+	/*
+		Returns the nearest entity to pos for which filter(id) is true,
+		or none if there is no such entity.
+		Tiles are visited in square rings around the tile of pos,
+		and the search stops as soon as no entity in the next rings
+		can be closer than the best one found.
+	*/
+	template <typename Tget_pos, typename Tfilter>
+	uint32_t find_nearest (const Vector& pos, Tget_pos&& get_pos, Tfilter&& filter) const
+	{
+		const int32_t cx = static_cast<int32_t>( this->clamp_x( std::floor(pos.x) ) );
+		const int32_t cy = static_cast<int32_t>( this->clamp_y( std::floor(pos.y) ) );
+		const int32_t w_ = static_cast<int32_t>(this->w);
+		const int32_t h_ = static_cast<int32_t>(this->h);
+		const int32_t max_ring = std::max( std::max(cx, w_ - 1 - cx), std::max(cy, h_ - 1 - cy) );
+
+		uint32_t best = none;
+		float best_distance_sq = std::numeric_limits<float>::max();
+
+		auto visit_tile = [&] (const int32_t x, const int32_t y) {
+			for (uint32_t id = this->head[y * w_ + x]; id != none; id = this->next[id]) {
+				if (!filter(id))
+					continue;
+
+				const Vector d = get_pos(id) - pos;
+				const float distance_sq = d.x*d.x + d.y*d.y;
+
+				if (distance_sq < best_distance_sq) {
+					best_distance_sq = distance_sq;
+					best = id;
+				}
+			}
+		};
+
+		for (int32_t r = 0; r <= max_ring; r++) {
+			const int32_t x_begin = std::max(cx - r, 0);
+			const int32_t x_end = std::min(cx + r, w_ - 1);
+			const int32_t y_begin = std::max(cy - r + 1, 0);
+			const int32_t y_end = std::min(cy + r - 1, h_ - 1);
+
+			// top and bottom rows of the ring
+			if ((cy - r) >= 0) {
+				for (int32_t x = x_begin; x <= x_end; x++)
+					visit_tile(x, cy - r);
+			}
+
+			if (r > 0 && (cy + r) < h_) {
+				for (int32_t x = x_begin; x <= x_end; x++)
+					visit_tile(x, cy + r);
+			}
+
+			// left and right columns of the ring, without the corners
+			if (r > 0 && (cx - r) >= 0) {
+				for (int32_t y = y_begin; y <= y_end; y++)
+					visit_tile(cx - r, y);
+			}
+
+			if (r > 0 && (cx + r) < w_) {
+				for (int32_t y = y_begin; y <= y_end; y++)
+					visit_tile(cx + r, y);
+			}
+
+			// entities in the next rings are at least r tiles away
+			const float min_next_distance = static_cast<float>(r) * Config::map_tile_size;
+
+			if (best != none && best_distance_sq <= (min_next_distance * min_next_distance))
+				break;
+		}
+
+		return best;
+	}
+
+protected:
+	inline uint32_t clamp_x (const float x) const
+	{
+		return static_cast<uint32_t>( std::clamp(static_cast<int32_t>(x), 0, static_cast<int32_t>(this->w) - 1) );
+	}
+
+	inline uint32_t clamp_y (const float y) const
+	{
+		return static_cast<uint32_t>( std::clamp(static_cast<int32_t>(y), 0, static_cast<int32_t>(this->h) - 1) );
+	}
+
+	inline void link (const uint32_t id, const uint32_t tile)
+	{
+		const uint32_t first = this->head[tile];
+
+		this->prev[id] = none;
+		this->next[id] = first;
+
+		if (first != none)
+			this->prev[first] = id;
+
+		this->head[tile] = id;
+		this->tile_of[id] = tile;
+	}
+
+	inline void unlink (const uint32_t id)
+	{
+		const uint32_t p = this->prev[id];
+		const uint32_t n = this->next[id];
+
+		if (p != none)
+			this->next[p] = n;
+		else
+			this->head[ this->tile_of[id] ] = n;
+
+		if (n != none)
+			this->prev[n] = p;
+
+		this->tile_of[id] = none;
+	}
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <algorithm>
+
+#include "thread-pool.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+ThreadPool::ThreadPool (const uint32_t n_workers_)
+{
+	mylib_assert_exception_msg(n_workers_ > 0, "a thread pool needs at least one worker")
+
+	this->n_workers = n_workers_;
+	this->generation = 0;
+	this->n_busy_threads = 0;
+	this->stop = false;
+	this->n_pending_tasks = 0;
+	this->job = Job { .func = nullptr, .call = nullptr };
+
+	this->workers.reserve(this->n_workers);
+
+	for (uint32_t i = 0; i < this->n_workers; i++)
+		this->workers.push_back( std::make_unique<Worker>() );
+
+	// worker 0 is the thread that calls parallel_for
+	for (uint32_t i = 1; i < this->n_workers; i++)
+		this->workers[i]->thread = std::thread(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool ()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stop = true;
+	}
+
+	this->cv_start.notify_all();
+
+	for (uint32_t i = 1; i < this->n_workers; i++)
+		this->workers[i]->thread.join();
+}
+
+uint32_t ThreadPool::get_default_n_workers ()
+{
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void ThreadPool::run (const uint32_t n_tasks, const Job& job_)
+{
+	// deal the tasks in contiguous blocks, so that each worker
+	// starts with neighbouring data
+
+	const uint32_t n_tasks_per_worker = (n_tasks + this->n_workers - 1) / this->n_workers;
+
+	for (uint32_t i = 0; i < this->n_workers; i++) {
+		Worker& worker = *this->workers[i];
+		const uint32_t begin = std::min(i * n_tasks_per_worker, n_tasks);
+		const uint32_t end = std::min(begin + n_tasks_per_worker, n_tasks);
+
+		std::lock_guard<std::mutex> lock(worker.mutex);
+
+		for (uint32_t task = begin; task < end; task++)
+			worker.tasks.push_back(task);
+	}
+
+	this->n_pending_tasks.store(n_tasks, std::memory_order_release);
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->job = job_;
+		this->n_busy_threads = this->n_workers - 1;
+		this->generation++;
+	}
+
+	this->cv_start.notify_all();
+
+	this->work(0);
+
+	// wait for the other workers to leave the job, so that the next
+	// parallel_for cannot overwrite it while they still use it
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->cv_done.wait(lock, [this] { return this->n_busy_threads == 0; });
+}
+
+void ThreadPool::worker_loop (const uint32_t worker_id)
+{
+	uint64_t last_generation = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->cv_start.wait(lock, [this, last_generation] { return this->stop || this->generation != last_generation; });
+
+			if (this->stop)
+				return;
+
+			last_generation = this->generation;
+		}
+
+		this->work(worker_id);
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->n_busy_threads--;
+		}
+
+		this->cv_done.notify_one();
+	}
+}
+
+void ThreadPool::work (const uint32_t worker_id)
+{
+	uint32_t task;
+
+	while (this->n_pending_tasks.load(std::memory_order_acquire) > 0) {
+		if (!this->pop_task(worker_id, task)) {
+			// the remaining tasks are running on other workers
+			std::this_thread::yield();
+			continue;
+		}
+
+		this->job.call(this->job.func, task, worker_id);
+		this->n_pending_tasks.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+bool ThreadPool::pop_task (const uint32_t worker_id, uint32_t& task)
+{
+	{
+		Worker& self = *this->workers[worker_id];
+		std::lock_guard<std::mutex> lock(self.mutex);
+
+		if (!self.tasks.empty()) {
+			task = self.tasks.front();
+			self.tasks.pop_front();
+			return true;
+		}
+	}
+
+	for (uint32_t i = 1; i < this->n_workers; i++) {
+		Worker& victim = *this->workers[(worker_id + i) % this->n_workers];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.tasks.empty()) {
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
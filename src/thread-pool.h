@@ -0,0 +1,107 @@
+#ifndef __PACMAN_SDL_OPENGL_THREAD_POOL_HEADER_H__
+#define __PACMAN_SDL_OPENGL_THREAD_POOL_HEADER_H__
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Work-stealing thread pool for data-parallel loops.
+	parallel_for splits the work in tasks, deals them to the workers'
+	queues in contiguous blocks, and each worker pops tasks from the
+	front of its own queue and steals from the back of the others
+	when its queue is empty.
+	The calling thread works as worker 0, so a pool with n_workers
+	creates (n_workers - 1) threads.
+*/
+
+class ThreadPool
+{
+protected:
+	struct Worker {
+		std::mutex mutex;
+		std::deque<uint32_t> tasks;
+		std::thread thread;
+	};
+
+	// type-erased reference to the loop body of the current parallel_for
+	struct Job {
+		void *func;
+		void (*call) (void *func, const uint32_t task, const uint32_t worker_id);
+	};
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, n_workers)
+
+	std::vector< std::unique_ptr<Worker> > workers;
+
+	std::mutex mutex;
+	std::condition_variable cv_start;
+	std::condition_variable cv_done;
+	Job job;
+	uint64_t generation;
+	uint32_t n_busy_threads;
+	bool stop;
+
+	std::atomic<uint32_t> n_pending_tasks;
+
+public:
+	ThreadPool (const uint32_t n_workers_);
+	~ThreadPool ();
+
+	ThreadPool (const ThreadPool&) = delete;
+	ThreadPool& operator= (const ThreadPool&) = delete;
+
+	/*
+		Calls func(task, worker_id) for every task in [0, n_tasks),
+		and returns when all of them are done.
+		worker_id is in [0, n_workers), and a worker never runs
+		two tasks at the same time, so it can be used to index
+		per-worker scratch data.
+	*/
+	template <typename Tfunc>
+	void parallel_for (const uint32_t n_tasks, Tfunc&& func)
+	{
+		if (n_tasks == 0)
+			return;
+
+		if (this->n_workers == 1 || n_tasks == 1) {
+			for (uint32_t task = 0; task < n_tasks; task++)
+				func(task, 0);
+			return;
+		}
+
+		this->run(n_tasks, Job {
+			.func = static_cast<void*>(&func),
+			.call = [] (void *f, const uint32_t task, const uint32_t worker_id) {
+				(*static_cast<std::remove_reference_t<Tfunc>*>(f))(task, worker_id);
+			}
+			});
+	}
+
+	static uint32_t get_default_n_workers ();
+
+protected:
+	void run (const uint32_t n_tasks, const Job& job_);
+	void worker_loop (const uint32_t worker_id);
+	void work (const uint32_t worker_id);
+	bool pop_task (const uint32_t worker_id, uint32_t& task);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
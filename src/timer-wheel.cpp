@@ -0,0 +1,251 @@
+#include <utility>
+#include <algorithm>
+
+#include "timer-wheel.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+TimingWheel::TimingWheel (const ClockTime& clock_)
+	: clock(clock_)
+{
+	this->origin = this->clock;
+	this->resolution = float_to_ClockDuration(Config::timer_wheel_resolution);
+	this->current_tick = 0;
+	this->heads.fill(none);
+	this->firing = none;
+	this->firing_cancelled = false;
+	this->n_pending = 0;
+	this->n_fired = 0;
+}
+
+TimingWheel::Descriptor TimingWheel::schedule_event (const ClockTime time, Callback callback)
+{
+	uint32_t id = this->heads[list_free];
+
+	if (id != none)
+		this->unlink(id);
+	else {
+		id = static_cast<uint32_t>( this->nodes.size() );
+		this->nodes.push_back( Node { .list = none, .generation = 0 } );
+	}
+
+	Node& node = this->nodes[id];
+	node.time = time;
+	node.tick = this->time_to_tick(time);
+	node.callback = std::move(callback);
+
+	this->insert(id);
+	this->n_pending++;
+
+	return Descriptor { .id = id, .generation = node.generation };
+}
+
+void TimingWheel::unschedule_event (const Descriptor descriptor)
+{
+	if (descriptor.id >= this->nodes.size())
+		return;
+
+	Node& node = this->nodes[descriptor.id];
+
+	if (node.generation != descriptor.generation || node.list == list_free)
+		return;
+
+	if (descriptor.id == this->firing) {
+		this->firing_cancelled = true;
+		return;
+	}
+
+	this->unlink(descriptor.id);
+
+	node.callback = nullptr;
+	node.generation++;
+	this->link(descriptor.id, list_free);
+	this->n_pending--;
+}
+
+void TimingWheel::trigger_events ()
+{
+	constexpr uint64_t mask = n_slots - 1;
+	const ClockTime now = this->clock;
+
+	if (now < this->origin)
+		return;
+
+	const uint64_t target_tick = static_cast<uint64_t>( (now - this->origin) / this->resolution );
+
+	// nothing to cascade or expire, so we can jump
+	if (this->n_pending == 0 && target_tick > this->current_tick)
+		this->current_tick = target_tick;
+
+	while (this->current_tick < target_tick) {
+		const uint64_t tick = ++this->current_tick;
+		uint32_t level;
+
+		// when the wheel of a level wraps around, bring down the next slot of the level above
+		for (level = 1; level < n_levels; level++) {
+			if (((tick >> (n_slot_bits * (level - 1))) & mask) != 0)
+				break;
+
+			this->cascade(level);
+		}
+
+		if (level == n_levels && ((tick >> (n_slot_bits * (n_levels - 1))) & mask) == 0)
+			this->cascade(n_levels);
+
+		this->expire_slot(static_cast<uint32_t>(tick & mask));
+	}
+}
+
+ClockTime TimingWheel::get_event_time (const Descriptor descriptor) const
+{
+	mylib_assert_exception_msg(descriptor.id < this->nodes.size() && this->nodes[descriptor.id].generation == descriptor.generation && this->nodes[descriptor.id].list != list_free, "timer event ", descriptor.id, " is not pending")
+
+	return this->nodes[descriptor.id].time;
+}
+
+void TimingWheel::resync ()
+{
+	const ClockTime now = this->clock;
+	std::vector<uint32_t>& pending = this->resync_pending;
+
+	pending.clear();
+
+	for (uint32_t list = 0; list < list_free; list++) {
+		uint32_t id;
+
+		while ((id = this->heads[list]) != none) {
+			this->unlink(id);
+			pending.push_back(id);
+		}
+	}
+
+	// same as trigger_events would have left it
+	this->current_tick = (now <= this->origin) ? 0 : static_cast<uint64_t>( (now - this->origin) / this->resolution );
+
+	for (const uint32_t id : pending)
+		this->insert(id);
+}
+
+uint64_t TimingWheel::time_to_tick (const ClockTime time) const
+{
+	if (time <= this->origin)
+		return 0;
+
+	// round up, so that events never fire early
+	const ClockDuration d = time - this->origin;
+
+	return static_cast<uint64_t>( (d + this->resolution - ClockDuration(1)) / this->resolution );
+}
+
+void TimingWheel::insert (const uint32_t id)
+{
+	// overdue events fire in the next tick
+	const uint64_t tick = std::max(this->nodes[id].tick, this->current_tick + 1);
+	const uint64_t delta = tick - this->current_tick;
+
+	for (uint32_t level = 0; level < n_levels; level++) {
+		if (delta < (static_cast<uint64_t>(1) << (n_slot_bits * (level + 1)))) {
+			const uint32_t slot = static_cast<uint32_t>( (tick >> (n_slot_bits * level)) & (n_slots - 1) );
+			this->link(id, level * n_slots + slot);
+			return;
+		}
+	}
+
+	this->link(id, list_overflow);
+}
+
+void TimingWheel::link (const uint32_t id, const uint32_t list)
+{
+	Node& node = this->nodes[id];
+	const uint32_t first = this->heads[list];
+
+	node.prev = none;
+	node.next = first;
+	node.list = list;
+
+	if (first != none)
+		this->nodes[first].prev = id;
+
+	this->heads[list] = id;
+}
+
+void TimingWheel::unlink (const uint32_t id)
+{
+	Node& node = this->nodes[id];
+
+	if (node.prev != none)
+		this->nodes[node.prev].next = node.next;
+	else
+		this->heads[node.list] = node.next;
+
+	if (node.next != none)
+		this->nodes[node.next].prev = node.prev;
+
+	node.list = none;
+}
+
+/*
+	Re-inserts the events of the current slot of the level,
+	which now fit in the lower levels.
+	Level n_levels stands for the overflow list.
+*/
+
+void TimingWheel::cascade (const uint32_t level)
+{
+	const uint32_t list = (level < n_levels)
+	                    ? level * n_slots + static_cast<uint32_t>( (this->current_tick >> (n_slot_bits * level)) & (n_slots - 1) )
+	                    : list_overflow;
+
+	uint32_t id = this->heads[list];
+	this->heads[list] = none;
+
+	while (id != none) {
+		const uint32_t next = this->nodes[id].next;
+		this->insert(id);
+		id = next;
+	}
+}
+
+void TimingWheel::expire_slot (const uint32_t slot)
+{
+	uint32_t id;
+
+	// callbacks may schedule or cancel events, so we always restart from the head
+	while ((id = this->heads[slot]) != none) {
+		this->unlink(id);
+
+		// the callback may schedule events and re-allocate the nodes
+		Callback callback = std::move(this->nodes[id].callback);
+		Event event { .time = this->nodes[id].time, .re_schedule = false };
+
+		this->firing = id;
+		this->firing_cancelled = false;
+
+		callback(event);
+
+		this->firing = none;
+		this->n_fired++;
+
+		Node& node = this->nodes[id];
+
+		if (event.re_schedule && !this->firing_cancelled) {
+			node.time = event.time;
+			node.tick = this->time_to_tick(event.time);
+			node.callback = std::move(callback);
+			this->insert(id);
+		}
+		else {
+			node.generation++;
+			this->link(id, list_free);
+			this->n_pending--;
+		}
+	}
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
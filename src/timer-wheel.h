@@ -0,0 +1,126 @@
+#ifndef __PACMAN_SDL_OPENGL_TIMER_WHEEL_HEADER_H__
+#define __PACMAN_SDL_OPENGL_TIMER_WHEEL_HEADER_H__
+
+#include <vector>
+#include <array>
+#include <functional>
+#include <limits>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "config.h"
+#include "lib.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Hierarchical timing wheel.
+	Time is divided in ticks of Config::timer_wheel_resolution.
+	Level L has n_slots slots of n_slots^L ticks each, and an event is
+	stored in the lowest level that can hold its distance to the current tick.
+	When the wheel of a level wraps around, the next slot of the level
+	above is cascaded down, so every event is moved at most n_levels times.
+	Schedule and cancel are O(1), and trigger_events expires whole slots.
+
+	Events never fire before their time, and fire at most one tick late.
+*/
+
+class TimingWheel
+{
+public:
+	struct Event {
+		ClockTime time;
+		bool re_schedule; // set by the callback, with a new time, to fire again
+	};
+
+	using Callback = std::function<void (Event&)>;
+
+	struct Descriptor {
+		uint32_t id = std::numeric_limits<uint32_t>::max();
+		uint32_t generation = 0;
+	};
+
+	static constexpr uint32_t n_slot_bits = 8;
+	static constexpr uint32_t n_slots = 1 << n_slot_bits;
+	static constexpr uint32_t n_levels = 4;
+
+protected:
+	static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+	// lists of the slots of all levels, followed by these two
+	static constexpr uint32_t list_overflow = n_slots * n_levels; // too far away for the wheels
+	static constexpr uint32_t list_free = list_overflow + 1;
+	static constexpr uint32_t n_lists = list_free + 1;
+
+	struct Node {
+		ClockTime time;
+		uint64_t tick;
+		Callback callback;
+		uint32_t next;
+		uint32_t prev;
+		uint32_t list;
+		uint32_t generation;
+	};
+
+	const ClockTime& clock; // advanced by the owner of the wheel
+	ClockTime origin;
+	ClockDuration resolution;
+	uint64_t current_tick; // all ticks up to this one were expired
+
+	std::vector<Node> nodes;
+	std::array<uint32_t, n_lists> heads;
+
+	// pending events while resync reinserts them, kept to reuse its memory
+	std::vector<uint32_t> resync_pending;
+
+	// node being fired, so that the callback can cancel itself
+	uint32_t firing;
+	bool firing_cancelled;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_pending)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, n_fired)
+
+public:
+	TimingWheel (const ClockTime& clock_);
+
+	inline ClockTime get_current_time () const
+	{
+		return this->clock;
+	}
+
+	Descriptor schedule_event (const ClockTime time, Callback callback);
+
+	// it is safe to cancel an event that already fired, or from inside a callback
+	void unschedule_event (const Descriptor descriptor);
+
+	// fires all events whose time is not after the current time
+	void trigger_events ();
+
+	// the event must be pending
+	ClockTime get_event_time (const Descriptor descriptor) const;
+
+	/*
+		Must be called after the clock jumps, e.g. back in time when
+		a world state is restored. The pending events are filed again
+		for the new current time, keeping their absolute times.
+	*/
+	void resync ();
+
+protected:
+	uint64_t time_to_tick (const ClockTime time) const;
+	void insert (const uint32_t id);
+	void link (const uint32_t id, const uint32_t list);
+	void unlink (const uint32_t id);
+	void cascade (const uint32_t level);
+	void expire_slot (const uint32_t slot);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
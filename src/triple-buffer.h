@@ -0,0 +1,69 @@
+#ifndef __PACMAN_SDL_OPENGL_TRIPLE_BUFFER_HEADER_H__
+#define __PACMAN_SDL_OPENGL_TRIPLE_BUFFER_HEADER_H__
+
+#include <array>
+#include <atomic>
+
+#include <my-lib/std.h>
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Lock-free triple buffer, for a single producer and a single consumer.
+	The producer writes into the back buffer and publishes it, which
+	swaps it with the middle buffer. The consumer takes the middle buffer
+	as its front buffer if something was published since its last
+	acquire, otherwise it keeps the one it has.
+	Neither side ever waits, and the consumer always gets the latest
+	buffer that was published.
+*/
+
+template <typename T>
+class TripleBuffer
+{
+protected:
+	static constexpr uint32_t fresh_bit = 0x04; // the middle buffer was published after the last acquire
+	static constexpr uint32_t index_mask = 0x03;
+
+	std::array<T, 3> buffers;
+	std::atomic<uint32_t> middle;
+	uint32_t back; // producer only
+	uint32_t front; // consumer only
+
+public:
+	TripleBuffer ()
+		: middle(1), back(0), front(2)
+	{
+	}
+
+	// producer
+
+	inline T& get_back ()
+	{
+		return this->buffers[this->back];
+	}
+
+	inline void publish ()
+	{
+		this->back = this->middle.exchange(this->back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+	}
+
+	// consumer
+
+	inline const T& acquire ()
+	{
+		if (this->middle.load(std::memory_order_relaxed) & fresh_bit)
+			this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & index_mask;
+
+		return this->buffers[this->front];
+	}
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
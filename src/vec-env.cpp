@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <utility>
+
+#include <cstring>
+
+#include "vec-env.h"
+#include "config.h"
+#include "debug.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+VecEnv::VecEnv (const Map& map, const uint32_t n_envs, ThreadPool *pool_)
+	: pool(pool_)
+{
+	mylib_assert_exception_msg(n_envs > 0, "a VecEnv needs at least one environment")
+
+	this->map_w = map.get_w();
+	this->map_h = map.get_h();
+	this->words_per_row = (this->map_w + 63) / 64;
+	this->plane_words = this->map_h * this->words_per_row;
+	this->observation_words = n_planes * this->plane_words;
+
+	this->walls_plane.assign(this->plane_words, 0);
+
+	for (uint32_t y = 0; y < this->map_h; y++) {
+		for (uint32_t x = 0; x < this->map_w; x++) {
+			if (map[y, x] == Map::Cell::Wall)
+				this->walls_plane[y * this->words_per_row + x / 64] |= uint64_t(1) << (x % 64);
+		}
+	}
+
+	this->worlds.resize(n_envs);
+	this->prev_contacts.assign(n_envs, 0);
+
+	// the seeds are given at reset
+	for (uint32_t i = 0; i < n_envs; i++)
+		this->worlds[i] = std::make_unique<World>(Map(map), 0);
+
+	this->worlds[0]->save_state(this->initial_state);
+
+	dprintln("created ", n_envs, " environments of ", this->map_w, "x", this->map_h, ", ", this->observation_words, " words per observation");
+}
+
+template <typename Tfunc>
+void VecEnv::for_each_env (Tfunc&& func)
+{
+	const uint32_t n_envs = this->size();
+	const uint32_t n_chunks = (n_envs + Config::vec_env_chunk_size - 1) / Config::vec_env_chunk_size;
+
+	auto run_chunk = [&func, n_envs] (const uint32_t chunk, const uint32_t worker_id) {
+		const uint32_t begin = chunk * Config::vec_env_chunk_size;
+		const uint32_t end = std::min(begin + Config::vec_env_chunk_size, n_envs);
+
+		for (uint32_t i = begin; i < end; i++)
+			func(i);
+	};
+
+	if (this->pool != nullptr)
+		this->pool->parallel_for(n_chunks, run_chunk);
+	else {
+		for (uint32_t chunk = 0; chunk < n_chunks; chunk++)
+			run_chunk(chunk, 0);
+	}
+}
+
+void VecEnv::reset (const uint64_t seed, uint64_t *observations)
+{
+	this->for_each_env([this, seed, observations] (const uint32_t i) {
+		this->reset(i, seed + i, observations + static_cast<size_t>(i) * this->observation_words);
+	});
+}
+
+void VecEnv::reset (const uint32_t env, const uint64_t seed, uint64_t *observations)
+{
+	World& world = *this->worlds[env];
+
+	world.restore_state(this->initial_state, seed);
+	this->prev_contacts[env] = world.get_n_ghost_contacts();
+
+	this->observe(env, observations);
+}
+
+void VecEnv::step (const Action *actions, uint64_t *observations, uint32_t *contacts)
+{
+	this->for_each_env([this, actions, observations, contacts] (const uint32_t i) {
+		World& world = *this->worlds[i];
+
+		world.get_ref_context().move.publish( Events::MoveData { .direction = actions[i] } );
+		world.step(Config::sim_dt, nullptr);
+
+		const uint64_t n_contacts = world.get_n_ghost_contacts();
+
+		if (contacts != nullptr)
+			contacts[i] = static_cast<uint32_t>(n_contacts - this->prev_contacts[i]);
+
+		this->prev_contacts[i] = n_contacts;
+
+		this->observe(i, observations + static_cast<size_t>(i) * this->observation_words);
+	});
+}
+
+void VecEnv::observe (const uint32_t env, uint64_t *observation) const
+{
+	const World& world = *this->worlds[env];
+	const Ghosts& ghosts = world.get_ref_ghosts();
+	const uint32_t n_ghosts = ghosts.size();
+
+	uint64_t *pacman_plane = observation + std::to_underlying(Plane::Pacman) * this->plane_words;
+	uint64_t *ghosts_plane = observation + std::to_underlying(Plane::Ghosts) * this->plane_words;
+
+	auto set = [this] (uint64_t *plane, const float fx, const float fy) {
+		const uint32_t x = std::min(static_cast<uint32_t>( std::max(fx, 0.0f) ), this->map_w - 1);
+		const uint32_t y = std::min(static_cast<uint32_t>( std::max(fy, 0.0f) ), this->map_h - 1);
+
+		plane[y * this->words_per_row + x / 64] |= uint64_t(1) << (x % 64);
+	};
+
+	std::memcpy(observation + std::to_underlying(Plane::Walls) * this->plane_words, this->walls_plane.data(), this->plane_words * sizeof(uint64_t));
+	std::memset(pacman_plane, 0, this->plane_words * sizeof(uint64_t));
+	std::memset(ghosts_plane, 0, this->plane_words * sizeof(uint64_t));
+
+	set(pacman_plane, world.get_ref_player().get_x(), world.get_ref_player().get_y());
+
+	for (uint32_t i = 0; i < n_ghosts; i++)
+		set(ghosts_plane, ghosts.get_ref_x()[i], ghosts.get_ref_y()[i]);
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
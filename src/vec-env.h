@@ -0,0 +1,111 @@
+#ifndef __PACMAN_SDL_OPENGL_VEC_ENV_HEADER_H__
+#define __PACMAN_SDL_OPENGL_VEC_ENV_HEADER_H__
+
+#include <vector>
+#include <memory>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "events.h"
+#include "thread-pool.h"
+#include "game-world.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	A batch of headless worlds of the same map, as environments for
+	training agents. Each step takes one action per environment,
+	advances every world by Config::sim_dt and writes the observations
+	into buffers of the caller. Stepping allocates nothing. A reset
+	restores the initial state, which may rebuild the flow field.
+
+	An action is an Events::MoveData::Direction, published as the move
+	of the player. Stopped cancels a pending turn, and the player keeps
+	going in its current direction.
+
+	The observation of an environment is n_planes bit-planes of the map,
+	in the order of Plane, each of map_h rows of words_per_row uint64_t.
+	Tile (x, y) is bit (x % 64) of word (y * words_per_row + x / 64)
+	of its plane. The observations of the environments are back to back,
+	observation_words apart.
+*/
+
+class VecEnv
+{
+public:
+	using Action = Events::MoveData::Direction;
+
+	enum class Plane : uint32_t {
+		Walls,
+		Pacman,
+		Ghosts
+	};
+
+	static constexpr uint32_t n_planes = 3;
+
+protected:
+	ThreadPool *pool; // if null, the environments are stepped in the calling thread
+	std::vector< std::unique_ptr<World> > worlds;
+
+	// all worlds start from this state, see World::restore_state
+	std::vector<uint8_t> initial_state;
+
+	// contacts of each world before the current step
+	std::vector<uint64_t> prev_contacts;
+
+	// the walls never change, so their plane is copied into every observation
+	std::vector<uint64_t> walls_plane;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, map_w)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, map_h)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, words_per_row)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, plane_words)
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint32_t, observation_words)
+
+public:
+	VecEnv (const Map& map, const uint32_t n_envs, ThreadPool *pool_);
+
+	inline uint32_t size () const
+	{
+		return static_cast<uint32_t>( this->worlds.size() );
+	}
+
+	inline World& get_world (const uint32_t i)
+	{
+		return *this->worlds[i];
+	}
+
+	inline const World& get_world (const uint32_t i) const
+	{
+		return *this->worlds[i];
+	}
+
+	// starts a new game in every environment, environment i with the seed (seed + i)
+	void reset (const uint64_t seed, uint64_t *observations);
+
+	// starts a new game in a single environment, e.g. at the end of its episode
+	void reset (const uint32_t env, const uint64_t seed, uint64_t *observations);
+
+	/*
+		actions has one action per environment.
+		contacts may be null, otherwise it receives, per environment,
+		the number of pacman-ghost contacts in this step.
+	*/
+	void step (const Action *actions, uint64_t *observations, uint32_t *contacts);
+
+protected:
+	void observe (const uint32_t env, uint64_t *observation) const;
+
+	template <typename Tfunc>
+	void for_each_env (Tfunc&& func);
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
@@ -0,0 +1,48 @@
+#include "world-batch.h"
+#include "debug.h"
+
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+WorldBatch::WorldBatch (ThreadPool& pool_, const Map& map, const uint64_t first_seed_, const uint32_t n_worlds)
+	: pool(pool_)
+{
+	this->first_seed = first_seed_;
+	this->worlds.resize(n_worlds);
+
+	// each world builds its own walls and flow field, so we create them in parallel too
+	this->pool.parallel_for(n_worlds, [this, &map] (const uint32_t i, const uint32_t worker_id) {
+		this->worlds[i] = std::make_unique<World>(Map(map), this->first_seed + i);
+	});
+}
+
+void WorldBatch::run (const uint64_t n_ticks, const float dt, const Controller& controller)
+{
+	this->pool.parallel_for(this->size(), [this, n_ticks, dt, &controller] (const uint32_t i, const uint32_t worker_id) {
+		World& world = *this->worlds[i];
+
+		for (uint64_t tick = 0; tick < n_ticks; tick++) {
+			if (controller)
+				controller(world, i);
+
+			world.step(dt, nullptr);
+		}
+	});
+}
+
+uint64_t WorldBatch::get_state_hash () const
+{
+	uint64_t hash = 0xCBF29CE484222325;
+
+	for (const auto& world : this->worlds)
+		hash = (hash ^ world->get_state_hash()) * 0x100000001B3;
+
+	return hash;
+}
+
+// ---------------------------------------------------
+
+} // end namespace Game
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef __PACMAN_SDL_OPENGL_WORLD_BATCH_HEADER_H__
+#define __PACMAN_SDL_OPENGL_WORLD_BATCH_HEADER_H__
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include <my-lib/std.h>
+#include <my-lib/macros.h>
+
+#include "thread-pool.h"
+#include "game-world.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Many independent headless worlds of the same map, with
+	consecutive seeds, stepped in parallel over a thread pool.
+	The parallelism is over worlds: each world is a single task,
+	has its own WorldContext and no thread pool of its own, so it
+	is only touched by the worker that steps it, and the results
+	don't depend on the number of threads.
+*/
+
+class WorldBatch
+{
+public:
+	// called before every step of a world, by the worker that steps it,
+	// e.g. to publish moves to the context of the world
+	using Controller = std::function<void (World& world, const uint32_t world_id)>;
+
+protected:
+	ThreadPool& pool;
+	std::vector< std::unique_ptr<World> > worlds;
+
+	MYLIB_OO_ENCAPSULATE_SCALAR_READONLY(uint64_t, first_seed)
+
+public:
+	// world i gets the seed (first_seed_ + i)
+	WorldBatch (ThreadPool& pool_, const Map& map, const uint64_t first_seed_, const uint32_t n_worlds);
+
+	inline uint32_t size () const
+	{
+		return static_cast<uint32_t>( this->worlds.size() );
+	}
+
+	inline World& get_world (const uint32_t i)
+	{
+		return *this->worlds[i];
+	}
+
+	inline const World& get_world (const uint32_t i) const
+	{
+		return *this->worlds[i];
+	}
+
+	// steps every world n_ticks times
+	void run (const uint64_t n_ticks, const float dt, const Controller& controller = nullptr);
+
+	// combines the state hashes of all worlds, in order
+	uint64_t get_state_hash () const;
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef __PACMAN_SDL_OPENGL_WORLD_CONTEXT_HEADER_H__
+#define __PACMAN_SDL_OPENGL_WORLD_CONTEXT_HEADER_H__
+
+#include <my-lib/std.h>
+
+#include <my-game-lib/my-game-lib.h>
+
+#include "lib.h"
+#include "events.h"
+#include "renderer.h"
+
+namespace Game
+{
+
+// ---------------------------------------------------
+
+/*
+	Everything a world shares with the code around it: its clock,
+	its timers and events, and where it draws to and gets input from.
+	Each World owns its context, so many worlds can be simulated
+	side by side, as long as each one is used by a single thread at a time.
+	Headless worlds have neither renderer nor event manager.
+*/
+
+struct WorldContext {
+	/*
+		Simulation time.
+		It only advances when the world is stepped, so that game logic
+		behaves the same in real time and in headless runs.
+	*/
+	ClockTime sim_time;
+
+	Events::Timer timer; // runs on sim_time
+	Events::Move move;
+	Events::WallCollision wall_collision;
+	Events::GhostContact ghost_contact;
+
+	Renderer *renderer;
+	MyGlib::Event::Manager *event_manager;
+
+	WorldContext ()
+		: sim_time(),
+		  timer(sim_time),
+		  renderer(nullptr),
+		  event_manager(nullptr)
+	{
+	}
+
+	// the timer refers to sim_time, and the events to their subscribers
+	WorldContext (const WorldContext&) = delete;
+	WorldContext& operator= (const WorldContext&) = delete;
+};
+
+// ---------------------------------------------------
+
+} // end namespace Game
+
+#endif
\ No newline at end of file